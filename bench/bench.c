@@ -0,0 +1,588 @@
+#include "debugmalloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "errors.h"
+#include "vector.h"
+#include "canvas.h"
+#include "mlp.h"
+#include "brush.h"
+#include "filehandler.h"
+#include "snippets.h"
+#include "stats.h"
+#include "raylib.h"
+#include "perf.h"
+
+/** The longest name of a benchmark case. */
+#define BENCH_NAME 64
+/** The longest line of a baseline file. */
+#define BENCH_LINE 512
+/** How many times a case that seems slower than its baseline is measured again. */
+#define BENCH_RETRIES 3
+
+
+/** A benchmarked operation, called with the argument of its case. */
+typedef void (*BenchFunction)(void *arg);
+
+
+/** A single measured operation. */
+typedef struct BenchCase {
+    char name[BENCH_NAME];
+    BenchFunction function;
+    void *arg;
+    /** Multiply-accumulate operations of a call, zero if the case doesn't compute any. */
+    double macs;
+} BenchCase;
+
+
+/** The measurements of a case. */
+typedef struct BenchResult {
+    char name[BENCH_NAME];
+    /** Number of calls in a single sample. */
+    size_t iterations;
+    /** Statistics of the time of a single call in seconds. */
+    Summary summary;
+    double macs;
+    /** The hardware events of a single call, only valid if the run has counters. */
+    double events[PERF_EVENTS];
+} BenchResult;
+
+
+/** Settings of the benchmark run. */
+typedef struct BenchOptions {
+    const char *models;
+    /** Only the cases whose name contains this are run, NULL to run every case. */
+    const char *filter;
+    const char *output;
+    /** The earlier results to compare to, NULL to skip the comparison. */
+    const char *baseline;
+    /** The allowed slowdown compared to the baseline in percents. */
+    double threshold;
+    /** Number of samples per case. */
+    size_t repeat;
+    /** Duration of the warm-up per case in seconds, it also sets the number of calls per sample. */
+    double warmup;
+    /** The shortest duration of a sample in seconds. */
+    double sample;
+    /** True to also count hardware events. */
+    bool counters;
+} BenchOptions;
+
+
+/** Argument of the brush cases. */
+typedef struct BrushArg {
+    MLP *mlp;
+    TOOL tool;
+    int radius;
+    /** Counts the calls to move the brush around the Canvas. */
+    size_t step;
+} BrushArg;
+
+
+/** Argument of the Canvas cases. */
+typedef struct CanvasArg {
+    size_t width, height;
+    Canvas canvas;
+} CanvasArg;
+
+
+static void bench_read_model(void *arg)
+{
+    ReadResult read = read_model((const char*) arg, "bench");
+    if(read.status == SUCCESS)
+        free_mlp(&read.model);
+}
+
+
+static void bench_load_input(void *arg)
+{
+    load_mlp_input((MLP*) arg);
+}
+
+
+static void bench_run_mlp(void *arg)
+{
+    run_mlp((MLP*) arg);
+}
+
+
+static void bench_draw_brush(void *arg)
+{
+    BrushArg *b = (BrushArg*) arg;
+    // a fixed walk over the Canvas, so every run draws the same cells
+    Vector2 pos = {(b->step*7) % b->mlp->x, (b->step*3) % b->mlp->y};
+    b->step++;
+
+    draw_brush(b->mlp, &pos, b->tool, false, b->radius);
+}
+
+
+static void bench_create_canvas(void *arg)
+{
+    CanvasArg *c = (CanvasArg*) arg;
+    Canvas canvas = create_canvas(c->width, c->height);
+    free_canvas(&canvas);
+}
+
+
+static void bench_clear_canvas(void *arg)
+{
+    clear_canvas(&((CanvasArg*) arg)->canvas);
+}
+
+
+static void bench_push_vector(void *arg)
+{
+    size_t n = *(const size_t*) arg;
+    Vector v = create_vector(1, sizeof(double), false);
+    for(size_t i = 0; i < n; i++)
+    {
+        double d = i;
+        push_vector(&v, &d);
+    }
+    free_vector(&v);
+}
+
+
+/**
+ * Compares two paths for qsort().
+ * 
+ * \param a Pointer to the first path.
+ * \param b Pointer to the second path.
+ * 
+ * \returns The result of strcmp() on the paths.
+ */
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(*(const char* const*) a, *(const char* const*) b);
+}
+
+
+/**
+ * Adds a case to the list of cases, unless it's filtered out.
+ * 
+ * \param cases Pointer to the Vector of cases.
+ * \param opt Pointer to the options.
+ * \param function The benchmarked operation.
+ * \param arg The argument of the operation.
+ * \param macs Multiply-accumulate operations of a call, zero if the case doesn't compute any.
+ * \param name The name of the case as a format string, followed by its arguments.
+ */
+static void add_case(Vector *cases, const BenchOptions *opt, BenchFunction function, void *arg, double macs, const char *name, ...)
+{
+    BenchCase c = {"", function, arg, macs};
+
+    va_list args;
+    va_start(args, name);
+    vsnprintf(c.name, sizeof(c.name), name, args);
+    va_end(args);
+
+    if(opt->filter == NULL || strstr(c.name, opt->filter) != NULL)
+        push_vector(cases, &c);
+}
+
+
+/**
+ * Draws the same strokes on a model's drawing Canvas on every run, so the models get a realistic input.
+ * 
+ * \param mlp Pointer to the model.
+ */
+static void draw_sample(MLP *mlp)
+{
+    Vector2 a = {mlp->x * 0.3f, mlp->y * 0.2f};
+    Vector2 b = {mlp->x * 0.7f, mlp->y * 0.5f};
+    Vector2 c = {mlp->x * 0.4f, mlp->y * 0.8f};
+    int radius = max(1, (int) mlp->x / 14);
+
+    draw_stroke(mlp, &a, &b, BRUSH, false, radius);
+    draw_stroke(mlp, &b, &c, BRUSH, false, radius);
+}
+
+
+/**
+ * Counts the multiply-accumulate operations of a model's run.
+ * 
+ * \param mlp Pointer to the model.
+ * 
+ * \returns The number of weights between the layers.
+ */
+static double count_macs(const MLP *mlp)
+{
+    double macs = 0;
+    for(size_t i = 0; i+1 < mlp->layers.size; i++)
+        macs += (double) get_vector_as_type(&mlp->layers, i, Vector).size * get_vector_as_type(&mlp->layers, i+1, Vector).size;
+
+    return macs;
+}
+
+
+/**
+ * Measures a case: warms it up, chooses the number of calls per sample and takes the samples.
+ * 
+ * \param c Pointer to the case.
+ * \param opt Pointer to the options.
+ * \param perf Pointer to the counters, counting during every sample. NULL to only measure the time.
+ * 
+ * \returns The measurements of the case.
+ */
+static BenchResult measure(const BenchCase *c, const BenchOptions *opt, PerfCounters *perf)
+{
+    BenchResult r = {"", 1, {0}, c->macs, {0}};
+    strcpy(r.name, c->name);
+
+    // the warm-up fills the caches and estimates the duration of a call
+    size_t calls = 0;
+    double start = now_seconds(), elapsed;
+    do
+    {
+        c->function(c->arg);
+        calls++;
+        elapsed = now_seconds() - start;
+    } while(elapsed < opt->warmup);
+
+    double call = elapsed / calls;
+    if(call < opt->sample)
+        r.iterations = (size_t) (opt->sample / call) + 1;
+
+    Vector samples = create_vector(opt->repeat, sizeof(double), false);
+    if(perf != NULL)
+        start_perf_counters(perf);
+
+    for(size_t i = 0; i < opt->repeat; i++)
+    {
+        double t = now_seconds();
+        for(size_t j = 0; j < r.iterations; j++)
+            c->function(c->arg);
+        t = (now_seconds() - t) / r.iterations;
+
+        push_vector(&samples, &t);
+    }
+
+    if(perf != NULL)
+    {
+        stop_perf_counters(perf);
+        for(int i = 0; i < PERF_EVENTS; i++)
+            r.events[i] = perf->value[i] / (opt->repeat * r.iterations);
+    }
+
+    r.summary = summarize(&samples);
+    free_vector(&samples);
+
+    return r;
+}
+
+
+/**
+ * Writes a derived value of the hardware events as a JSON field, or null if an event isn't counted.
+ * 
+ * \param f The stream to write to.
+ * \param name The name of the field.
+ * \param valid True if the events of the value are counted.
+ * \param value The value.
+ */
+static void write_event(FILE *f, const char *name, bool valid, double value)
+{
+    if(valid)
+        fprintf(f, ", \"%s\": %.4lf", name, value);
+    else
+        fprintf(f, ", \"%s\": null", name);
+}
+
+
+/**
+ * Writes the measurements of a case as a single line of JSON.
+ * 
+ * \param f The stream to write to.
+ * \param r Pointer to the measurements.
+ * \param perf Pointer to the counters the events were counted with, NULL if they weren't counted.
+ */
+static void write_result(FILE *f, const BenchResult *r, const PerfCounters *perf)
+{
+    const Summary *s = &r->summary;
+    fprintf(f, "{\"name\": \"%s\", \"samples\": %zu, \"iterations\": %zu, \"median_ns\": %.1lf, \"p99_ns\": %.1lf, "
+        "\"mean_ns\": %.1lf, \"stddev_ns\": %.1lf, \"min_ns\": %.1lf, \"max_ns\": %.1lf",
+        r->name, s->count, r->iterations, s->median*1e9, s->p99*1e9, s->mean*1e9, s->stddev*1e9, s->min*1e9, s->max*1e9);
+
+    if(perf != NULL)
+    {
+        const double *e = r->events;
+        bool cycles = perf_available(perf, CYCLES), instructions = perf_available(perf, INSTRUCTIONS);
+        bool l1d = perf_available(perf, L1D_MISSES), llc = perf_available(perf, LLC_MISSES);
+
+        write_event(f, "cycles", cycles, e[CYCLES]);
+        write_event(f, "instructions", instructions, e[INSTRUCTIONS]);
+        write_event(f, "ipc", cycles && instructions && e[CYCLES] > 0, e[INSTRUCTIONS] / e[CYCLES]);
+        write_event(f, "l1d_misses", l1d, e[L1D_MISSES]);
+        write_event(f, "llc_misses", llc, e[LLC_MISSES]);
+        write_event(f, "branch_misses", perf_available(perf, BRANCH_MISSES), e[BRANCH_MISSES]);
+
+        // the misses per multiply-accumulate show how well a kernel reuses its data, independently of the model's size
+        if(r->macs > 0)
+        {
+            fprintf(f, ", \"macs\": %.0lf", r->macs);
+            write_event(f, "l1d_misses_per_mac", l1d, e[L1D_MISSES] / r->macs);
+            write_event(f, "llc_misses_per_mac", llc, e[LLC_MISSES] / r->macs);
+        }
+    }
+
+    fprintf(f, "}\n");
+    fflush(f);
+}
+
+
+/**
+ * Reads the results of an earlier run written by write_result().
+ * 
+ * \param path Path to the earlier results.
+ * \param baseline Pointer to the Vector receiving the results as BenchResult values, only their names, medians and p99 are read.
+ * 
+ * \returns True if the file could be opened.
+ */
+static bool read_baseline(const char *path, Vector *baseline)
+{
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+        return false;
+
+    char line[BENCH_LINE];
+    while(fgets(line, sizeof(line), f) != NULL)
+    {
+        BenchResult r = {"", 0, {0}, 0, {0}};
+        const char *median = strstr(line, "\"median_ns\": ");
+        const char *p99 = strstr(line, "\"p99_ns\": ");
+        if(sscanf(line, " {\"name\": \"%63[^\"]\"", r.name) != 1 || median == NULL || sscanf(median, "\"median_ns\": %lf", &r.summary.median) != 1
+            || p99 == NULL || sscanf(p99, "\"p99_ns\": %lf", &r.summary.p99) != 1)
+            continue;
+
+        r.summary.median /= 1e9;
+        r.summary.p99 /= 1e9;
+        push_vector(baseline, &r);
+    }
+    fclose(f);
+
+    return true;
+}
+
+
+/**
+ * Looks up a case in the earlier results.
+ * 
+ * \param baseline Pointer to the Vector of earlier results.
+ * \param name The name of the case.
+ * 
+ * \returns Pointer to the earlier result, NULL if the case wasn't measured.
+ */
+static const BenchResult* find_baseline(const Vector *baseline, const char *name)
+{
+    for(size_t i = 0; i < baseline->size; i++)
+    {
+        const BenchResult *b = &get_vector_as_type(baseline, i, BenchResult);
+        if(strcmp(b->name, name) == 0)
+            return b;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Checks if a case got slower than allowed. Its median has to be above the threshold and the baseline's p99 too,
+ * so a median that is still within the baseline's own samples doesn't count as a regression.
+ * 
+ * \param r Pointer to the new result.
+ * \param b Pointer to the earlier result.
+ * \param threshold The allowed slowdown in percents.
+ * 
+ * \returns True if the case is slower than allowed.
+ */
+static bool is_regression(const BenchResult *r, const BenchResult *b, double threshold)
+{
+    return r->summary.median > b->summary.median * (1 + threshold/100) && r->summary.median > b->summary.p99;
+}
+
+
+/**
+ * Parses the command line arguments.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * \param opt Pointer to the options to fill.
+ * 
+ * \returns True if the arguments were valid.
+ */
+static bool parse_options(int argc, char *argv[], BenchOptions *opt)
+{
+    *opt = (BenchOptions) {".", NULL, NULL, NULL, 10, 50, 0.2, 0.002, false};
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i+1 < argc;
+
+        if(strcmp(argv[i], "--models") == 0 && has_value)
+            opt->models = argv[++i];
+        else if(strcmp(argv[i], "--filter") == 0 && has_value)
+            opt->filter = argv[++i];
+        else if(strcmp(argv[i], "--output") == 0 && has_value)
+            opt->output = argv[++i];
+        else if(strcmp(argv[i], "--baseline") == 0 && has_value)
+            opt->baseline = argv[++i];
+        else if(strcmp(argv[i], "--threshold") == 0 && has_value)
+            opt->threshold = atof(argv[++i]);
+        else if(strcmp(argv[i], "--repeat") == 0 && has_value)
+            opt->repeat = strtoul(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "--warmup") == 0 && has_value)
+            opt->warmup = atof(argv[++i]);
+        else if(strcmp(argv[i], "--counters") == 0)
+            opt->counters = true;
+        else
+            return false;
+    }
+
+    return opt->repeat > 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    BenchOptions opt;
+    if(!parse_options(argc, argv, &opt))
+    {
+        fprintf(stderr, "Usage: bench [--models dir] [--filter text] [--output path] [--repeat n] [--warmup seconds] [--counters]\n");
+        fprintf(stderr, "             [--baseline path [--threshold percent]]\n");
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_NONE);
+    debugmalloc_max_block_size(1 << 30);
+
+    // the bundled models in a fixed order, so the output of two runs can be compared line by line
+    FilePathList files = LoadDirectoryFilesEx(opt.models, ".mlpmodel", false);
+    qsort(files.paths, files.count, sizeof(char*), compare_paths);
+
+    Vector models = create_vector(files.count, sizeof(MLP), false);
+    for(size_t i = 0; i < files.count; i++)
+    {
+        ReadResult read = read_model(files.paths[i], GetFileNameWithoutExt(files.paths[i]));
+        if(read.status != SUCCESS)
+        {
+            fprintf(stderr, "Couldn't read the model '%s' (status %d)\n", files.paths[i], read.status);
+            continue;
+        }
+
+        draw_sample(&read.model);
+        load_mlp_input(&read.model);
+        push_vector(&models, &read.model);
+    }
+
+    if(models.size == 0)
+    {
+        fprintf(stderr, "There are no models in '%s'\n", opt.models);
+        UnloadDirectoryFiles(files);
+        free_vector(&models);
+        return 1;
+    }
+
+    Vector cases = create_vector(32, sizeof(BenchCase), false);
+    for(size_t i = 0; i < files.count; i++)
+        add_case(&cases, &opt, bench_read_model, files.paths[i], 0, "read_model/%s", GetFileNameWithoutExt(files.paths[i]));
+
+    for(size_t i = 0; i < models.size; i++)
+    {
+        MLP *mlp = &get_vector_as_type(&models, i, MLP);
+        add_case(&cases, &opt, bench_load_input, mlp, 0, "load_mlp_input/%s", mlp->name);
+        add_case(&cases, &opt, bench_run_mlp, mlp, count_macs(mlp), "run_mlp/%s", mlp->name);
+    }
+
+    // the brushes draw on the first model's Canvas after its own cases, the largest brush covers most of a 28x28 Canvas
+    MLP *first = &get_vector_as_type(&models, 0, MLP);
+    BrushArg brushes[] = {{first, PENCIL, 1, 0}, {first, BRUSH, 1, 0}, {first, BRUSH, 3, 0}, {first, BRUSH, 10, 0}};
+    for(size_t i = 0; i < sizeof(brushes)/sizeof(brushes[0]); i++)
+        add_case(&cases, &opt, bench_draw_brush, &brushes[i], 0, "draw_brush/%s_r%d", brushes[i].tool == PENCIL ? "pencil" : "brush", brushes[i].radius);
+
+    CanvasArg canvases[] = {{28, 28}, {56, 56}, {1024, 1024}};
+    for(size_t i = 0; i < sizeof(canvases)/sizeof(canvases[0]); i++)
+    {
+        canvases[i].canvas = create_canvas(canvases[i].width, canvases[i].height);
+        add_case(&cases, &opt, bench_create_canvas, &canvases[i], 0, "create_canvas/%zux%zu", canvases[i].width, canvases[i].height);
+        add_case(&cases, &opt, bench_clear_canvas, &canvases[i], 0, "clear_canvas/%zux%zu", canvases[i].width, canvases[i].height);
+    }
+
+    size_t pushes[] = {16, 1024, 65536};
+    for(size_t i = 0; i < sizeof(pushes)/sizeof(pushes[0]); i++)
+        add_case(&cases, &opt, bench_push_vector, &pushes[i], 0, "push_vector/%zu", pushes[i]);
+
+    FILE *out = opt.output == NULL ? stdout : fopen(opt.output, "w");
+    int code = 0;
+    if(out == NULL)
+    {
+        fprintf(stderr, "Couldn't open '%s' for writing\n", opt.output);
+        code = 1;
+    }
+
+    // the counters are optional, the times are measured and the events are written as null if the kernel doesn't allow counting
+    PerfCounters counters;
+    PerfCounters *perf = NULL;
+    if(opt.counters)
+    {
+        perf = &counters;
+        if(!open_perf_counters(perf))
+            fprintf(stderr, "Hardware counters aren't available, only the times are measured\n");
+    }
+
+    Vector baseline = create_vector(16, sizeof(BenchResult), false);
+    if(opt.baseline != NULL && !read_baseline(opt.baseline, &baseline))
+    {
+        fprintf(stderr, "Couldn't read the baseline '%s'\n", opt.baseline);
+        code = 1;
+    }
+
+    int regressions = 0;
+    for(size_t i = 0; i < cases.size && out != NULL && code == 0; i++)
+    {
+        const BenchCase *c = &get_vector_as_type(&cases, i, BenchCase);
+        BenchResult r = measure(c, &opt, perf);
+
+        // the other processes on the machine can slow down a whole case, a real regression stays slow when measured again
+        const BenchResult *b = find_baseline(&baseline, c->name);
+        for(int retry = 0; b != NULL && retry < BENCH_RETRIES && is_regression(&r, b, opt.threshold); retry++)
+        {
+            BenchResult again = measure(c, &opt, perf);
+            if(again.summary.median < r.summary.median)
+                r = again;
+        }
+
+        write_result(out, &r, perf);
+
+        if(b != NULL)
+        {
+            bool regressed = is_regression(&r, b, opt.threshold);
+            regressions += regressed;
+            fprintf(stderr, "%-40s %12.1lf ns -> %12.1lf ns %+8.2lf%%%s\n", c->name, b->summary.median*1e9, r.summary.median*1e9,
+                100.0 * (r.summary.median - b->summary.median) / b->summary.median, regressed ? "  REGRESSION" : "");
+        }
+    }
+
+    if(regressions > 0)
+    {
+        fprintf(stderr, "%d cases are more than %g%% slower than the baseline\n", regressions, opt.threshold);
+        code = 1;
+    }
+
+    if(perf != NULL)
+        close_perf_counters(perf);
+    if(out != NULL && out != stdout)
+        fclose(out);
+    for(size_t i = 0; i < sizeof(canvases)/sizeof(canvases[0]); i++)
+        free_canvas(&canvases[i].canvas);
+    for(size_t i = 0; i < models.size; i++)
+        free_mlp(&get_vector_as_type(&models, i, MLP));
+    free_vector(&baseline);
+    free_vector(&cases);
+    free_vector(&models);
+    free_brush_stamps();
+    UnloadDirectoryFiles(files);
+
+    return code;
+}
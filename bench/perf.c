@@ -0,0 +1,136 @@
+#include "debugmalloc.h"
+#include "perf.h"
+
+#ifdef __linux__
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+
+/**
+ * Opens a single counter of the calling thread.
+ * 
+ * \param type The type of the event.
+ * \param config The event within the type.
+ * 
+ * \returns The file descriptor of the counter, -1 if it isn't available.
+ */
+static int open_event(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+
+bool open_perf_counters(PerfCounters *p)
+{
+    p->fd[CYCLES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    p->fd[INSTRUCTIONS] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    p->fd[L1D_MISSES] = open_event(PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    p->fd[LLC_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    p->fd[BRANCH_MISSES] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+    bool any = false;
+    for(int i = 0; i < PERF_EVENTS; i++)
+    {
+        p->value[i] = 0;
+        any = any || p->fd[i] >= 0;
+    }
+
+    return any;
+}
+
+
+void start_perf_counters(PerfCounters *p)
+{
+    for(int i = 0; i < PERF_EVENTS; i++)
+    {
+        if(p->fd[i] < 0)
+            continue;
+
+        ioctl(p->fd[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(p->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+
+void stop_perf_counters(PerfCounters *p)
+{
+    for(int i = 0; i < PERF_EVENTS; i++)
+    {
+        if(p->fd[i] >= 0)
+            ioctl(p->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for(int i = 0; i < PERF_EVENTS; i++)
+    {
+        // value, time enabled and time running
+        uint64_t data[3];
+        p->value[i] = 0;
+        if(p->fd[i] < 0 || read(p->fd[i], data, sizeof(data)) != sizeof(data))
+            continue;
+
+        // the kernel multiplexes the events when there are more than hardware counters
+        p->value[i] = data[2] > 0 ? (double) data[0] * data[1] / data[2] : 0;
+    }
+}
+
+
+void close_perf_counters(PerfCounters *p)
+{
+    for(int i = 0; i < PERF_EVENTS; i++)
+    {
+        if(p->fd[i] >= 0)
+            close(p->fd[i]);
+        p->fd[i] = -1;
+    }
+}
+
+#else
+
+bool open_perf_counters(PerfCounters *p)
+{
+    for(int i = 0; i < PERF_EVENTS; i++)
+    {
+        p->fd[i] = -1;
+        p->value[i] = 0;
+    }
+
+    return false;
+}
+
+
+void start_perf_counters(PerfCounters *p)
+{
+}
+
+
+void stop_perf_counters(PerfCounters *p)
+{
+}
+
+
+void close_perf_counters(PerfCounters *p)
+{
+}
+
+#endif
+
+
+bool perf_available(const PerfCounters *p, PERFEVENT event)
+{
+    return p->fd[event] >= 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/** The measured hardware events. */
+typedef enum PERFEVENT {
+    CYCLES = 0,
+    INSTRUCTIONS,
+    L1D_MISSES,     /*!< Level 1 data cache read misses. */
+    LLC_MISSES,     /*!< Last level cache misses. */
+    BRANCH_MISSES,
+    PERF_EVENTS     /*!< Number of events, not an event. */
+} PERFEVENT;
+
+
+/** Hardware performance counters of the calling thread. */
+typedef struct PerfCounters {
+    /** File descriptors of the counters, -1 where an event isn't available. */
+    int fd[PERF_EVENTS];
+    /** The counts since the last start_perf_counters() call. */
+    double value[PERF_EVENTS];
+} PerfCounters;
+
+
+/**
+ * Opens the counters of the calling thread, only counting in user space.
+ * Every event is opened separately, so the available ones still work if some aren't supported.
+ * Outside Linux or without permission (e.g. in a container) none of them are available.
+ * 
+ * \param p Pointer to the counters to open.
+ * 
+ * \returns True if at least one event is available.
+ */
+bool open_perf_counters(PerfCounters *p);
+
+
+/**
+ * Resets and starts the available counters.
+ * 
+ * \param p Pointer to the counters.
+ */
+void start_perf_counters(PerfCounters *p);
+
+
+/**
+ * Stops the available counters and reads their values.
+ * The values are scaled up if the kernel only counted an event for part of the time.
+ * 
+ * \param p Pointer to the counters.
+ */
+void stop_perf_counters(PerfCounters *p);
+
+
+/**
+ * Checks if an event is counted.
+ * 
+ * \param p Pointer to the counters.
+ * \param event The event.
+ * 
+ * \returns True if the event's value is valid.
+ */
+bool perf_available(const PerfCounters *p, PERFEVENT event);
+
+
+/**
+ * Closes the counters.
+ * 
+ * \param p Pointer to the counters.
+ */
+void close_perf_counters(PerfCounters *p);
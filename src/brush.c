@@ -0,0 +1,126 @@
+#include "debugmalloc.h"
+#include "brush.h"
+#include <stdlib.h>
+#include <math.h>
+
+#include "errors.h"
+#include "snippets.h"
+
+
+/** Cached stamps, the element at index radius-1 belongs to the given radius. NULL if not computed yet. */
+static Vector stamps = {NULL, sizeof(double*), 0, 0};
+
+
+const double* get_brush_stamp(int radius)
+{
+    if(stamps.arr == NULL)
+        stamps = create_vector(1, sizeof(double*), false);
+
+    double *empty = NULL;
+    while(stamps.size < (size_t) radius)
+        push_vector(&stamps, &empty);
+
+    double **stamp = &get_vector_as_type(&stamps, radius-1, double*);
+    if(*stamp != NULL)
+        return *stamp;
+
+    int side = 2*radius-1;
+    *stamp = malloc(side * side * sizeof(double));
+    if(*stamp == NULL)
+        exit(ERR_NULLPOINTER);
+
+    for(int i = 0; i < side; i++)
+    {
+        for(int j = 0; j < side; j++)
+        {
+            double dist = distance(radius-1, radius-1, i, j);
+            (*stamp)[i*side + j] = dist > radius ? -1 : (radius-dist)/radius;
+        }
+    }
+
+    return *stamp;
+}
+
+
+/**
+ * Applies a stamp at a given cell of the drawing Canvas.
+ * 
+ * \param mlp Pointer to the MLP that contains the two Canvases.
+ * \param stamp The stamp that belongs to the radius.
+ * \param px X coordinate of the stamp's center.
+ * \param py Y coordinate of the stamp's center.
+ * \param tool BRUSH or PENCIL
+ * \param eraser Is the eraser enabled?
+ * \param radius The radius of the brush.
+ */
+static void apply_stamp(MLP *mlp, const double *stamp, long long px, long long py, TOOL tool, bool eraser, int radius)
+{
+    int side = 2*radius-1;
+    for(int si = 0; si < side; si++)
+    {
+        long long i = px-radius+1+si;
+        if(i < 0 || i >= (long long) mlp->x) continue;
+
+        for(int sj = 0; sj < side; sj++)
+        {
+            long long j = py-radius+1+sj;
+            if(j < 0 || j >= (long long) mlp->y) continue;
+
+            double weight = stamp[si*side + sj];
+            if(weight < 0)
+                continue;
+
+            double prev = get_canvas_xy(&mlp->canvas, i, j);
+            double curr = get_canvas_xy(&mlp->draw_canvas, i, j);
+            double change = 255 * weight;
+
+            curr = (tool == BRUSH) ? (eraser ? max(min(prev-change, curr), 0) : min(max(prev+change, curr), 255)) : (eraser ? 0 : 255);
+            set_canvas_xy(&mlp->draw_canvas, i, j, curr);
+        }
+    }
+}
+
+
+void draw_brush(MLP *mlp, Vector2 *pos, TOOL tool, bool eraser, int radius)
+{
+    apply_stamp(mlp, get_brush_stamp(radius), pos->x, pos->y, tool, eraser, radius);
+}
+
+
+void draw_stroke(MLP *mlp, Vector2 *from, Vector2 *to, TOOL tool, bool eraser, int radius)
+{
+    const double *stamp = get_brush_stamp(radius);
+
+    long long dx = (long long) to->x - (long long) from->x;
+    long long dy = (long long) to->y - (long long) from->y;
+    long long steps = max(llabs(dx), llabs(dy));
+
+    // the first stamp is skipped, it was drawn by the previous segment
+    for(long long s = steps == 0 ? 0 : 1; s <= steps; s++)
+    {
+        double t = steps == 0 ? 1 : (double) s/steps;
+        long long x = llround(from->x + dx*t);
+        long long y = llround(from->y + dy*t);
+        apply_stamp(mlp, stamp, x, y, tool, eraser, radius);
+    }
+}
+
+
+void end_stroke(MLP *mlp)
+{
+    for(size_t i = 0; i < mlp->x; i++)
+        for(size_t j = 0; j < mlp->y; j++)
+            set_canvas_xy(&mlp->canvas, i, j, get_canvas_xy(&mlp->draw_canvas, i, j));
+}
+
+
+void free_brush_stamps()
+{
+    if(stamps.arr == NULL)
+        return;
+
+    for(size_t i = 0; i < stamps.size; i++)
+        free(get_vector_as_type(&stamps, i, double*));
+
+    free_vector(&stamps);
+}
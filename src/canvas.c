@@ -1,5 +1,6 @@
 #include "debugmalloc.h"
 #include "canvas.h"
+#include <math.h>
 
 #include "snippets.h"
 
@@ -54,3 +55,13 @@ void clear_canvas(Canvas *canvas)
         }
     }
 }
+
+
+void canvas_pixels(const Canvas *canvas, unsigned char *out)
+{
+    for(size_t y = 0; y < canvas->height; y++)
+    {
+        for(size_t x = 0; x < canvas->width; x++)
+            out[y*canvas->width + x] = lround(get_canvas_xy(canvas, x, y));
+    }
+}
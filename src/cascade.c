@@ -0,0 +1,264 @@
+#include "debugmalloc.h"
+#include "cascade.h"
+#include <stdlib.h>
+
+#include "errors.h"
+#include "forward.h"
+#include "threadpool.h"
+#include "snippets.h"
+#include "stats.h"
+
+/** The tuned cascade may lose at most this much accuracy compared to the expensive model, in percentage points. */
+#define TUNE_TOLERANCE 0.1
+
+
+/** A contiguous range of images scored by a single task. */
+typedef struct ScoreChunk {
+    InferContext cheap, expensive;
+    size_t first, last;
+} ScoreChunk;
+
+
+/** The shared state of a scoring. */
+typedef struct ScoreJob {
+    const IdxFile *images;
+    CascadeScores *scores;
+    ScoreChunk *chunks;
+} ScoreJob;
+
+
+bool cascade_accepts(Cascade c, const double *prob, size_t size, size_t *result)
+{
+    size_t idx[2];
+    double best[2] = {0, 0};
+    topk(prob, size, 2, idx, best);
+
+    *result = idx[0];
+    return best[0] >= c.min_prob && best[0] - best[1] >= c.min_margin;
+}
+
+
+/**
+ * Scores a chunk of the dataset with both models. Called by the thread pool.
+ * 
+ * \param arg Pointer to the ScoreJob.
+ * \param index Index of the chunk.
+ */
+static void score_chunk(void *arg, size_t index)
+{
+    ScoreJob *job = (ScoreJob*) arg;
+    ScoreChunk *chunk = &job->chunks[index];
+    CascadeScores *s = job->scores;
+    const MLP *cheap = chunk->cheap.mlp;
+    const MLP *expensive = chunk->expensive.mlp;
+    const IdxFile *images = job->images;
+
+    double in_cheap[(cheap->x/cheap->kx) * (cheap->y/cheap->ky)];
+    double in_expensive[(expensive->x/expensive->kx) * (expensive->y/expensive->ky)];
+    double prob[chunk->cheap.outputs];
+
+    for(size_t i = chunk->first; i < chunk->last; i++)
+    {
+        const unsigned char *px = get_idx_item(images, i);
+
+        double start = now_seconds();
+        pool_pixels(cheap, px, images->cols, images->rows, in_cheap);
+        infer_mlp(&chunk->cheap, in_cheap);
+        infer_probabilities(&chunk->cheap, prob);
+        size_t best[2];
+        double p[2] = {0, 0};
+        topk(prob, chunk->cheap.outputs, 2, best, p);
+        size_t r = best[0];
+        double mid = now_seconds();
+        pool_pixels(expensive, px, images->cols, images->rows, in_expensive);
+        s->expensive_results[i] = infer_mlp(&chunk->expensive, in_expensive);
+        double end = now_seconds();
+
+        s->cheap_results[i] = r;
+        s->cheap_probs[i] = prob[r];
+        s->cheap_margins[i] = p[0] - p[1];
+        s->cheap_times[i] = mid - start;
+        s->expensive_times[i] = end - mid;
+    }
+}
+
+
+/**
+ * Allocates an array and exits if the allocation fails.
+ * 
+ * \param count Number of elements.
+ * \param size Size of an element.
+ * 
+ * \returns Pointer to the array.
+ */
+static void* alloc_array(size_t count, size_t size)
+{
+    void *p = malloc(max(count, (size_t) 1) * size);
+    if(p == NULL)
+        exit(ERR_NULLPOINTER);
+
+    return p;
+}
+
+
+CascadeScores score_cascade(const MLP *cheap, const MLP *expensive, const IdxFile *images, const IdxFile *labels)
+{
+    size_t count = min(images->count, labels->count);
+    size_t classes = get_vector_as_type(&cheap->layers, cheap->layers.size-1, Vector).size;
+
+    // everything is allocated here, because the workers mustn't use debugmalloc
+    CascadeScores s = {
+        count, classes,
+        (size_t*) alloc_array(count, sizeof(size_t)),
+        (size_t*) alloc_array(count, sizeof(size_t)),
+        (double*) alloc_array(count, sizeof(double)),
+        (double*) alloc_array(count, sizeof(double)),
+        (size_t*) alloc_array(count, sizeof(size_t)),
+        (double*) alloc_array(count, sizeof(double)),
+        (double*) alloc_array(count, sizeof(double))
+    };
+
+    for(size_t i = 0; i < count; i++)
+    {
+        size_t label = *get_idx_item(labels, i);
+        s.labels[i] = label < classes ? label : classes;
+    }
+
+    size_t n = thread_pool_size() * 4;
+    if(n > count)
+        n = count > 0 ? count : 1;
+
+    ScoreChunk *chunks = (ScoreChunk*) alloc_array(n, sizeof(ScoreChunk));
+    for(size_t i = 0; i < n; i++)
+        chunks[i] = (ScoreChunk) {create_infer_context(cheap), create_infer_context(expensive), count*i/n, count*(i+1)/n};
+
+    ScoreJob job = {images, &s, chunks};
+    run_parallel(score_chunk, &job, n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        free_infer_context(&chunks[i].cheap);
+        free_infer_context(&chunks[i].expensive);
+    }
+    free(chunks);
+
+    return s;
+}
+
+
+Evaluation evaluate_cascade(const CascadeScores *s, Cascade c, size_t *escalated, double *latency)
+{
+    size_t classes = s->classes;
+    Evaluation eval = {classes, 0, 0, 0, (size_t*) calloc(max(classes*classes, (size_t) 1), sizeof(size_t))};
+    if(eval.confusion == NULL)
+        exit(ERR_NULLPOINTER);
+
+    size_t esc = 0;
+    double time = 0;
+    for(size_t i = 0; i < s->count; i++)
+    {
+        size_t label = s->labels[i];
+        if(label == classes)
+        {
+            eval.skipped++;
+            continue;
+        }
+
+        size_t result = s->cheap_results[i];
+        time += s->cheap_times[i];
+        if(s->cheap_probs[i] < c.min_prob || s->cheap_margins[i] < c.min_margin)
+        {
+            result = s->expensive_results[i];
+            time += s->expensive_times[i];
+            esc++;
+        }
+
+        eval.confusion[label*classes + result]++;
+        eval.total++;
+        if(result == label)
+            eval.correct++;
+    }
+
+    *escalated = esc;
+    *latency = eval.total > 0 ? time/eval.total : 0;
+
+    return eval;
+}
+
+
+/**
+ * Writes a row of the tuning table.
+ * 
+ * \param f The stream to write to.
+ * \param s Pointer to the scores.
+ * \param c The thresholds.
+ * \param accuracy Pointer that receives the accuracy in percents.
+ * \param rate Pointer that receives the escalation rate in percents.
+ */
+static void tune_row(FILE *f, const CascadeScores *s, Cascade c, double *accuracy, double *rate)
+{
+    size_t escalated;
+    double latency;
+    Evaluation eval = evaluate_cascade(s, c, &escalated, &latency);
+
+    *accuracy = eval.total > 0 ? 100.0*eval.correct/eval.total : 0;
+    *rate = eval.total > 0 ? 100.0*escalated/eval.total : 0;
+    fprintf(f, "%8.3lf  %10.3lf  %7.2lf%%  %8.2lf%%  %10.1lf\n", c.min_prob, c.min_margin, *accuracy, *rate, latency*1e6);
+
+    free_evaluation(&eval);
+}
+
+
+bool tune_cascade(FILE *f, const CascadeScores *s, Cascade *best)
+{
+    static const double probs[] = {0, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95, 0.98, 0.99, 0.995, 0.999};
+    static const double margins[] = {0.1, 0.2, 0.3, 0.5, 0.7, 0.9, 0.95, 0.99};
+
+    // escalating everything gives the expensive model's accuracy
+    size_t escalated;
+    double latency;
+    Evaluation eval = evaluate_cascade(s, CASCADE_ALWAYS_ESCALATE, &escalated, &latency);
+    double target = (eval.total > 0 ? 100.0*eval.correct/eval.total : 0) - TUNE_TOLERANCE;
+    free_evaluation(&eval);
+
+    bool found = false;
+    double best_rate = 0;
+
+    fprintf(f, "min prob  min margin  accuracy  escalated  latency (us)\n");
+    for(size_t i = 0; i < sizeof(probs)/sizeof(probs[0]) + sizeof(margins)/sizeof(margins[0]); i++)
+    {
+        size_t np = sizeof(probs)/sizeof(probs[0]);
+        Cascade c = i < np ? (Cascade) {probs[i], 0} : (Cascade) {0, margins[i-np]};
+
+        double accuracy, rate;
+        tune_row(f, s, c, &accuracy, &rate);
+        if(accuracy >= target && (!found || rate < best_rate))
+        {
+            *best = c;
+            best_rate = rate;
+            found = true;
+        }
+    }
+
+    if(found)
+        fprintf(f, "\nSuggested: --min-prob %g --min-margin %g (within %.1lf points of the expensive model)\n",
+            best->min_prob, best->min_margin, TUNE_TOLERANCE);
+    else
+        fprintf(f, "\nNo suggestion: none of the thresholds stay within %.1lf points of the expensive model\n", TUNE_TOLERANCE);
+
+    return found;
+}
+
+
+void free_cascade_scores(CascadeScores *s)
+{
+    free(s->labels);
+    free(s->cheap_results);
+    free(s->cheap_probs);
+    free(s->cheap_margins);
+    free(s->expensive_results);
+    free(s->cheap_times);
+    free(s->expensive_times);
+    s->labels = s->cheap_results = s->expensive_results = NULL;
+    s->cheap_probs = s->cheap_margins = s->cheap_times = s->expensive_times = NULL;
+}
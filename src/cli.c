@@ -0,0 +1,890 @@
+#include "debugmalloc.h"
+#include "cli.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vector.h"
+#include "mlp.h"
+#include "filehandler.h"
+#include "snippets.h"
+#include "stats.h"
+#include "idx.h"
+#include "eval.h"
+#include "cascade.h"
+#include "ensemble.h"
+#include "forward.h"
+#include "threadpool.h"
+#include "server.h"
+#include "loadgen.h"
+#include "replay.h"
+#include "raylib.h"
+
+
+/** Settings of the headless inference mode. */
+typedef struct CliOptions {
+    const char *model;
+    /** Paths of the inputs as 'const char*' values. */
+    Vector inputs;
+    const char *output;
+    bool json;
+    size_t top;
+    bool invert;
+    /** Path of the expensive model of a cascade, NULL to only run the model. */
+    const char *cascade;
+    Cascade thresholds;
+} CliOptions;
+
+
+/** State shared by every classified input. */
+typedef struct CliRun {
+    CliOptions *opt;
+    MLP *mlp;
+    FILE *out;
+    /** Latency of each input in seconds as 'double' values. */
+    Vector latencies;
+    /** The expensive model of the cascade, only valid if the options have one. */
+    MLP expensive;
+    InferContext ctx;
+    /** Number of inputs the expensive model was run on. */
+    size_t escalated;
+    /** The ensemble answering instead of the model, NULL if the model is a single MLP. */
+    Ensemble *ensemble;
+} CliRun;
+
+
+/**
+ * Checks if a flag is among the command line arguments.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * \param flag The flag to look for.
+ * 
+ * \returns True if the flag is present.
+ */
+static bool has_flag(int argc, char *argv[], const char *flag)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], flag) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+
+bool is_cli(int argc, char *argv[])
+{
+    return has_flag(argc, argv, "--infer") || has_flag(argc, argv, "--eval") || has_flag(argc, argv, "--serve") || has_flag(argc, argv, "--loadgen") || has_flag(argc, argv, "--replay");
+}
+
+
+/**
+ * Prints the usage of the headless mode to the standard error.
+ */
+static void print_usage()
+{
+    fprintf(stderr, "Usage: --infer model.mlpmodel|models.ensemble [--input path]... [--format csv|json] [--output path] [--top k] [--invert]\n");
+    fprintf(stderr, "               [--cascade expensive.mlpmodel [--min-prob p] [--min-margin m]]\n");
+    fprintf(stderr, "       --eval model.mlpmodel|models.ensemble --images images-idx3-ubyte --labels labels-idx1-ubyte [--threads n]\n");
+    fprintf(stderr, "              [--cascade expensive.mlpmodel [--min-prob p] [--min-margin m] [--tune]]\n");
+}
+
+
+/**
+ * Parses the command line arguments of the headless mode.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * \param opt Pointer to the options to fill. Its inputs Vector has to be freed by the caller.
+ * 
+ * \returns True if the arguments were valid.
+ */
+static bool parse_options(int argc, char *argv[], CliOptions *opt)
+{
+    *opt = (CliOptions) {NULL, create_vector(1, sizeof(const char*), false), NULL, false, 1, false, NULL, {CASCADE_MIN_PROB, 0}};
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i+1 < argc;
+
+        if(strcmp(argv[i], "--infer") == 0 && has_value)
+            opt->model = argv[++i];
+        else if(strcmp(argv[i], "--input") == 0 && has_value)
+            push_vector(&opt->inputs, &argv[++i]);
+        else if(strcmp(argv[i], "--output") == 0 && has_value)
+            opt->output = argv[++i];
+        else if(strcmp(argv[i], "--format") == 0 && has_value)
+        {
+            i++;
+            if(strcmp(argv[i], "json") == 0)
+                opt->json = true;
+            else if(strcmp(argv[i], "csv") != 0)
+                return false;
+        }
+        else if(strcmp(argv[i], "--top") == 0 && has_value)
+        {
+            if(!parse_size(argv[++i], &opt->top))
+                return false;
+        }
+        else if(strcmp(argv[i], "--invert") == 0)
+            opt->invert = true;
+        else if(strcmp(argv[i], "--cascade") == 0 && has_value)
+            opt->cascade = argv[++i];
+        else if(strcmp(argv[i], "--min-prob") == 0 && has_value)
+            opt->thresholds.min_prob = atof(argv[++i]);
+        else if(strcmp(argv[i], "--min-margin") == 0 && has_value)
+            opt->thresholds.min_margin = atof(argv[++i]);
+        else
+            return false;
+    }
+
+    if(opt->inputs.size == 0)
+    {
+        const char *in = "-";
+        push_vector(&opt->inputs, &in);
+    }
+
+    return opt->model != NULL;
+}
+
+
+/**
+ * Queries the number of outputs of a model.
+ * 
+ * \param mlp Pointer to the model.
+ * 
+ * \returns The size of the output layer.
+ */
+static size_t output_count(const MLP *mlp)
+{
+    return get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector).size;
+}
+
+
+/**
+ * Reads the expensive model of a cascade and checks that it answers in the cheap model's classes.
+ * 
+ * \param cheap Pointer to the cheap model.
+ * \param path Path to the expensive model.
+ * \param expensive Pointer to the MLP receiving the expensive model. Only valid if the reading was successful.
+ * 
+ * \returns True if the model could be read and has as many outputs as the cheap model.
+ */
+static bool read_expensive(const MLP *cheap, const char *path, MLP *expensive)
+{
+    ReadResult read = read_model(path, GetFileNameWithoutExt(path));
+    if(read.status != SUCCESS)
+    {
+        fprintf(stderr, "Couldn't read the model '%s' (status %d)\n", path, read.status);
+        return false;
+    }
+
+    if(output_count(&read.model) != output_count(cheap))
+    {
+        fprintf(stderr, "The models of a cascade must have the same number of outputs ('%s': %zu, '%s': %zu)\n",
+            cheap->name, output_count(cheap), read.model.name, output_count(&read.model));
+        free_mlp(&read.model);
+        return false;
+    }
+
+    *expensive = read.model;
+    return true;
+}
+
+
+/**
+ * Runs the expensive model of the cascade on the drawing Canvas of the cheap model.
+ * 
+ * \param run Pointer to the shared state.
+ * \param k Number of classes to find.
+ * \param idx Array of k elements, receives the indices of the most probable classes.
+ * \param prob Array of k elements, receives the probabilities of the classes.
+ * 
+ * \returns The number of found classes.
+ */
+static size_t escalate(CliRun *run, size_t k, size_t *idx, double *prob)
+{
+    const MLP *mlp = run->mlp;
+    const MLP *e = &run->expensive;
+    unsigned char px[mlp->x * mlp->y];
+    double in[(e->x/e->kx) * (e->y/e->ky)];
+    double out[run->ctx.outputs];
+
+    canvas_pixels(&mlp->draw_canvas, px);
+    pool_pixels(e, px, mlp->x, mlp->y, in);
+    infer_mlp(&run->ctx, in);
+    infer_probabilities(&run->ctx, out);
+    run->escalated++;
+
+    return topk(out, run->ctx.outputs, k, idx, prob);
+}
+
+
+/**
+ * Runs the ensemble on the drawing Canvas of its largest member.
+ * 
+ * \param run Pointer to the shared state.
+ * \param k Number of classes to find.
+ * \param idx Array of k elements, receives the indices of the most probable classes.
+ * \param prob Array of k elements, receives the combined probabilities of the classes.
+ * 
+ * \returns The number of found classes.
+ */
+static size_t classify_ensemble(CliRun *run, size_t k, size_t *idx, double *prob)
+{
+    const MLP *mlp = run->mlp;
+    unsigned char px[mlp->x * mlp->y];
+
+    canvas_pixels(&mlp->draw_canvas, px);
+    run_ensemble(run->ensemble, px, mlp->x, mlp->y);
+
+    return ensemble_topk(run->ensemble, k, idx, prob);
+}
+
+
+/**
+ * Writes the name of an input as a JSON string or as a CSV field.
+ * A CSV field is only quoted if it contains a separator, a quote or a line break.
+ * 
+ * \param f The stream to write to.
+ * \param name The name of the input.
+ * \param json True for JSON, false for CSV.
+ */
+static void write_name(FILE *f, const char *name, bool json)
+{
+    if(!json && strpbrk(name, ",\"\r\n") == NULL)
+    {
+        fputs(name, f);
+        return;
+    }
+
+    fputc('"', f);
+    for(const unsigned char *c = (const unsigned char*) name; *c != '\0'; c++)
+    {
+        if(!json)
+        {
+            // quotes are doubled inside a quoted CSV field
+            if(*c == '"')
+                fputc('"', f);
+            fputc(*c, f);
+        }
+        else if(*c == '"' || *c == '\\')
+            fprintf(f, "\\%c", *c);
+        else if(*c < 0x20)
+            fprintf(f, "\\u%04x", *c);
+        else
+            fputc(*c, f);
+    }
+    fputc('"', f);
+}
+
+
+/**
+ * Runs the model on the drawing Canvas and writes the prediction.
+ * With a cascade, the expensive model answers instead when the model isn't confident enough.
+ * 
+ * \param run Pointer to the shared state.
+ * \param name The name of the input in the output.
+ * \param start The time when the input's processing started.
+ */
+static void classify(CliRun *run, const char *name, double start)
+{
+    MLP *mlp = run->mlp;
+    size_t k = run->opt->top;
+    size_t idx[k];
+    double prob[k];
+
+    if(run->ensemble != NULL)
+        k = classify_ensemble(run, k, idx, prob);
+    else
+    {
+        load_mlp_input(mlp);
+        run_mlp_argmax(mlp);
+    }
+
+    bool accepted = true;
+    if(run->ensemble == NULL && run->opt->cascade != NULL)
+    {
+        mlp_probabilities(mlp);
+        Vector *output = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
+        double p[output->size];
+        for(size_t i = 0; i < output->size; i++)
+            p[i] = get_vector_as_type(output, i, Node).output;
+
+        size_t result;
+        accepted = cascade_accepts(run->opt->thresholds, p, output->size, &result);
+    }
+
+    if(run->ensemble == NULL)
+        k = accepted ? mlp_topk(mlp, k, idx, prob) : escalate(run, k, idx, prob);
+
+    double latency = now_seconds() - start;
+    push_vector(&run->latencies, &latency);
+
+    if(run->opt->json)
+    {
+        fprintf(run->out, "%s{\"input\": ", run->latencies.size > 1 ? ",\n" : "");
+        write_name(run->out, name, true);
+        fprintf(run->out, ", \"top\": [");
+        for(size_t i = 0; i < k; i++)
+            fprintf(run->out, "%s{\"class\": %zu, \"probability\": %.6lf}", i > 0 ? ", " : "", idx[i], prob[i]);
+        fprintf(run->out, "]}");
+    }
+    else
+    {
+        write_name(run->out, name, false);
+        for(size_t i = 0; i < k; i++)
+            fprintf(run->out, ",%zu,%.6lf", idx[i], prob[i]);
+        fprintf(run->out, "\n");
+    }
+}
+
+
+/**
+ * Classifies an image file, resized to the model's Canvas.
+ * 
+ * \param run Pointer to the shared state.
+ * \param path Path to the image.
+ * 
+ * \returns True if the image could be loaded.
+ */
+static bool classify_image(CliRun *run, const char *path)
+{
+    MLP *mlp = run->mlp;
+    double start = now_seconds();
+
+    Image img = LoadImage(path);
+    if(img.data == NULL)
+        return false;
+
+    ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE);
+    ImageResize(&img, mlp->x, mlp->y);
+
+    const unsigned char *px = (const unsigned char*) img.data;
+    for(size_t y = 0; y < mlp->y; y++)
+    {
+        for(size_t x = 0; x < mlp->x; x++)
+        {
+            unsigned char v = px[y*mlp->x + x];
+            set_canvas_xy(&mlp->draw_canvas, x, y, run->opt->invert ? 255-v : v);
+        }
+    }
+    UnloadImage(img);
+
+    classify(run, path, start);
+
+    return true;
+}
+
+
+/**
+ * Classifies every drawing of a text stream, one per line.
+ * 
+ * \param run Pointer to the shared state.
+ * \param f The stream to read from.
+ * \param path The name of the stream in the output.
+ * 
+ * \returns False if the stream ended in the middle of a drawing.
+ */
+static bool classify_stream(CliRun *run, FILE *f, const char *path)
+{
+    MLP *mlp = run->mlp;
+    size_t record = 0;
+
+    while(true)
+    {
+        double start = now_seconds();
+
+        for(size_t i = 0; i < mlp->x*mlp->y; i++)
+        {
+            double v;
+            if(fscanf(f, "%lf", &v) != 1)
+                return i == 0 && feof(f);
+
+            set_canvas_xy(&mlp->draw_canvas, i % mlp->x, i / mlp->x, run->opt->invert ? 255-v : v);
+        }
+
+        classify(run, TextFormat("%s:%zu", path, ++record), start);
+    }
+}
+
+
+/**
+ * Classifies a single input path.
+ * 
+ * \param run Pointer to the shared state.
+ * \param path Path to an image or a text file, or "-" for the standard input.
+ * 
+ * \returns True if the whole input was processed.
+ */
+static bool classify_input(CliRun *run, const char *path)
+{
+    if(strcmp(path, "-") == 0)
+        return classify_stream(run, stdin, path);
+
+    if(IsFileExtension(path, ".png;.bmp;.tga;.jpg;.gif;.pgm;.ppm;.qoi"))
+        return classify_image(run, path);
+
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+        return false;
+
+    bool ok = classify_stream(run, f, path);
+    fclose(f);
+
+    return ok;
+}
+
+
+/**
+ * Classifies every input of the options and writes the predictions and the latency statistics.
+ * 
+ * \param run Pointer to the shared state.
+ * 
+ * \returns The program's exit code.
+ */
+static int classify_all(CliRun *run)
+{
+    CliOptions *opt = run->opt;
+    FILE *out = run->out;
+    int code = 0;
+
+    if(opt->json)
+        fprintf(out, "[\n");
+    else
+    {
+        fprintf(out, "input");
+        for(size_t i = 1; i <= opt->top; i++)
+            fprintf(out, ",class%zu,probability%zu", i, i);
+        fprintf(out, "\n");
+    }
+
+    double start = now_seconds();
+    for(size_t i = 0; i < opt->inputs.size; i++)
+    {
+        const char *path = get_vector_as_type(&opt->inputs, i, const char*);
+        if(!classify_input(run, path))
+        {
+            fprintf(stderr, "Couldn't process the input '%s'\n", path);
+            code = 1;
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    if(opt->json)
+        fprintf(out, "\n]\n");
+
+    Summary s = summarize(&run->latencies);
+    fprintf(stderr, "%zu inputs in %.3lf s, %.1lf inputs/s\n", s.count, elapsed, elapsed > 0 ? s.count/elapsed : 0);
+    fprintf(stderr, "latency (us): mean %.1lf, p50 %.1lf, p95 %.1lf, p99 %.1lf, max %.1lf\n",
+        s.mean*1e6, s.median*1e6, s.p95*1e6, s.p99*1e6, s.max*1e6);
+
+    return code;
+}
+
+
+/**
+ * Explains why an ensemble couldn't be read on the standard error.
+ * 
+ * \param path Path to the ensemble's definition.
+ * \param read Pointer to the failed reading.
+ */
+static void print_ensemble_error(const char *path, const EnsembleRead *read)
+{
+    if(read->status == NOMODEL)
+        fprintf(stderr, "The ensemble '%s' doesn't list any models\n", path);
+    else if(read->status == OUTPUTMISMATCH)
+        fprintf(stderr, "The model on line %zu of the ensemble '%s' has a different number of outputs than the ones before it\n", read->line, path);
+    else if(read->status == WRONGINSTRUCTION)
+        fprintf(stderr, "Invalid line %zu in the ensemble '%s'\n", read->line, path);
+    else if(read->line > 0)
+        fprintf(stderr, "Couldn't read the model on line %zu of the ensemble '%s' (status %d)\n", read->line, path, read->status);
+    else
+        fprintf(stderr, "Couldn't open the ensemble '%s'\n", path);
+}
+
+
+/**
+ * Classifies the inputs of the options with an ensemble.
+ * The inputs are staged on the drawing Canvas of the member with the largest Canvas,
+ * so every other member resamples them from the highest resolution.
+ * 
+ * \param opt Pointer to the options. Its inputs Vector is freed.
+ * 
+ * \returns The program's exit code.
+ */
+static int infer_ensemble(CliOptions *opt)
+{
+    if(opt->cascade != NULL)
+    {
+        fprintf(stderr, "An ensemble can't be part of a cascade\n");
+        free_vector(&opt->inputs);
+        return 1;
+    }
+
+    EnsembleRead read = read_ensemble(opt->model);
+    if(read.status != SUCCESS)
+    {
+        print_ensemble_error(opt->model, &read);
+        free_vector(&opt->inputs);
+        return 1;
+    }
+
+    FILE *out = opt->output == NULL ? stdout : fopen(opt->output, "w");
+    if(out == NULL)
+    {
+        fprintf(stderr, "Couldn't open '%s' for writing\n", opt->output);
+        free_ensemble(&read.ensemble);
+        free_vector(&opt->inputs);
+        return 1;
+    }
+
+    start_thread_pool(0);
+    opt->top = min(opt->top, read.ensemble.classes);
+
+    CliRun run = {opt, &largest_member(&read.ensemble)->mlp, out, create_vector(64, sizeof(double), false)};
+    run.ensemble = &read.ensemble;
+    int code = classify_all(&run);
+
+    stop_thread_pool();
+    if(out != stdout)
+        fclose(out);
+    free_vector(&run.latencies);
+    free_ensemble(&read.ensemble);
+    free_vector(&opt->inputs);
+
+    return code;
+}
+
+
+/**
+ * Classifies the inputs given on the command line.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns The program's exit code.
+ */
+static int run_infer(int argc, char *argv[])
+{
+    CliOptions opt;
+    if(!parse_options(argc, argv, &opt))
+    {
+        print_usage();
+        free_vector(&opt.inputs);
+        return 1;
+    }
+
+    if(IsFileExtension(opt.model, ".ensemble"))
+        return infer_ensemble(&opt);
+
+    ReadResult read = read_model(opt.model, GetFileNameWithoutExt(opt.model));
+    if(read.status != SUCCESS)
+    {
+        fprintf(stderr, "Couldn't read the model '%s' (status %d)\n", opt.model, read.status);
+        free_vector(&opt.inputs);
+        return 1;
+    }
+
+    FILE *out = opt.output == NULL ? stdout : fopen(opt.output, "w");
+    if(out == NULL)
+    {
+        fprintf(stderr, "Couldn't open '%s' for writing\n", opt.output);
+        free_mlp(&read.model);
+        free_vector(&opt.inputs);
+        return 1;
+    }
+
+    // the header and the rows have a column pair for each of the top classes
+    opt.top = min(opt.top, output_count(&read.model));
+
+    CliRun run = {&opt, &read.model, out, create_vector(64, sizeof(double), false)};
+
+    if(opt.cascade != NULL)
+    {
+        if(!read_expensive(&read.model, opt.cascade, &run.expensive))
+        {
+            if(out != stdout)
+                fclose(out);
+            free_vector(&run.latencies);
+            free_mlp(&read.model);
+            free_vector(&opt.inputs);
+            return 1;
+        }
+
+        run.ctx = create_infer_context(&run.expensive);
+    }
+
+    int code = classify_all(&run);
+
+    if(opt.cascade != NULL)
+    {
+        size_t count = run.latencies.size;
+        fprintf(stderr, "escalated to '%s': %zu (%.2lf%%)\n", run.expensive.name, run.escalated, count > 0 ? 100.0*run.escalated/count : 0);
+        free_infer_context(&run.ctx);
+        free_mlp(&run.expensive);
+    }
+
+    if(out != stdout)
+        fclose(out);
+    free_vector(&run.latencies);
+    free_mlp(&read.model);
+    free_vector(&opt.inputs);
+
+    return code;
+}
+
+
+/**
+ * Evaluates a single model on a dataset and writes the results.
+ * 
+ * \param mlp Pointer to the model.
+ * \param images Pointer to the images.
+ * \param labels Pointer to the labels.
+ * 
+ * \returns The program's exit code.
+ */
+static int eval_single(const MLP *mlp, const IdxFile *images, const IdxFile *labels)
+{
+    double start = now_seconds();
+    Evaluation eval = evaluate_mlp(mlp, images, labels);
+    double elapsed = now_seconds() - start;
+
+    print_evaluation(stdout, &eval);
+    fprintf(stderr, "%zu images in %.3lf s on %zu threads, %.1lf images/s\n",
+        eval.total + eval.skipped, elapsed, thread_pool_size(), elapsed > 0 ? (eval.total + eval.skipped)/elapsed : 0);
+
+    free_evaluation(&eval);
+    return 0;
+}
+
+
+/**
+ * Calculates the average of an array.
+ * 
+ * \param values The array.
+ * \param n Number of elements.
+ * 
+ * \returns The average, zero if the array is empty.
+ */
+static double average(const double *values, size_t n)
+{
+    double sum = 0;
+    for(size_t i = 0; i < n; i++)
+        sum += values[i];
+
+    return n > 0 ? sum/n : 0;
+}
+
+
+/**
+ * Evaluates a cascade of a cheap and an expensive model on a dataset and writes the results.
+ * 
+ * \param cheap Pointer to the cheap model.
+ * \param path Path to the expensive model.
+ * \param thresholds The thresholds of the cascade, unless they are tuned.
+ * \param tune True to choose the thresholds based on the dataset.
+ * \param images Pointer to the images.
+ * \param labels Pointer to the labels.
+ * 
+ * \returns The program's exit code.
+ */
+static int eval_cascade(const MLP *cheap, const char *path, Cascade thresholds, bool tune, const IdxFile *images, const IdxFile *labels)
+{
+    MLP model;
+    if(!read_expensive(cheap, path, &model))
+        return 1;
+
+    const MLP *expensive = &model;
+
+    double start = now_seconds();
+    CascadeScores scores = score_cascade(cheap, expensive, images, labels);
+    double elapsed = now_seconds() - start;
+
+    size_t escalated;
+    double latency;
+    Evaluation eval = evaluate_cascade(&scores, (Cascade) {0, 0}, &escalated, &latency);
+    printf("Cheap model '%s': %.2lf%% accuracy, %.1lf us per image\n", cheap->name,
+        eval.total > 0 ? 100.0*eval.correct/eval.total : 0, average(scores.cheap_times, scores.count)*1e6);
+    free_evaluation(&eval);
+
+    eval = evaluate_cascade(&scores, CASCADE_ALWAYS_ESCALATE, &escalated, &latency);
+    printf("Expensive model '%s': %.2lf%% accuracy, %.1lf us per image\n\n", expensive->name,
+        eval.total > 0 ? 100.0*eval.correct/eval.total : 0, average(scores.expensive_times, scores.count)*1e6);
+    free_evaluation(&eval);
+
+    if(tune)
+    {
+        tune_cascade(stdout, &scores, &thresholds);
+        printf("\n");
+    }
+
+    eval = evaluate_cascade(&scores, thresholds, &escalated, &latency);
+    printf("Cascade with --min-prob %g --min-margin %g: escalated %zu (%.2lf%%), %.1lf us per image\n",
+        thresholds.min_prob, thresholds.min_margin, escalated, eval.total > 0 ? 100.0*escalated/eval.total : 0, latency*1e6);
+    print_evaluation(stdout, &eval);
+    fprintf(stderr, "%zu images scored by both models in %.3lf s on %zu threads\n", scores.count, elapsed, thread_pool_size());
+
+    free_evaluation(&eval);
+    free_cascade_scores(&scores);
+    free_mlp(&model);
+
+    return 0;
+}
+
+
+/**
+ * Evaluates an ensemble on a dataset and writes the results.
+ * The members of each image run concurrently on the thread pool.
+ * 
+ * \param path Path to the ensemble's definition.
+ * \param threads Number of threads, 0 to use every processor.
+ * \param images Pointer to the images.
+ * \param labels Pointer to the labels.
+ * 
+ * \returns The program's exit code.
+ */
+static int eval_ensemble(const char *path, size_t threads, const IdxFile *images, const IdxFile *labels)
+{
+    EnsembleRead read = read_ensemble(path);
+    if(read.status != SUCCESS)
+    {
+        print_ensemble_error(path, &read);
+        return 1;
+    }
+
+    start_thread_pool(threads);
+
+    double start = now_seconds();
+    Evaluation eval = evaluate_ensemble(&read.ensemble, images, labels);
+    double elapsed = now_seconds() - start;
+
+    printf("Ensemble of %zu models, %s\n", read.ensemble.count, read.ensemble.mode == AVERAGE ? "averaged" : "voted");
+    print_evaluation(stdout, &eval);
+    fprintf(stderr, "%zu images in %.3lf s on %zu threads, %.1lf images/s\n",
+        eval.total + eval.skipped, elapsed, thread_pool_size(), elapsed > 0 ? (eval.total + eval.skipped)/elapsed : 0);
+
+    stop_thread_pool();
+    free_evaluation(&eval);
+    free_ensemble(&read.ensemble);
+
+    return 0;
+}
+
+
+/**
+ * Evaluates a model on an IDX dataset given on the command line.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns The program's exit code.
+ */
+static int run_eval(int argc, char *argv[])
+{
+    const char *model = NULL, *images_path = NULL, *labels_path = NULL, *cascade = NULL;
+    Cascade thresholds = {CASCADE_MIN_PROB, 0};
+    bool tune = false, bad = false;
+    size_t threads = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i+1 < argc;
+
+        if(strcmp(argv[i], "--eval") == 0 && has_value)
+            model = argv[++i];
+        else if(strcmp(argv[i], "--images") == 0 && has_value)
+            images_path = argv[++i];
+        else if(strcmp(argv[i], "--labels") == 0 && has_value)
+            labels_path = argv[++i];
+        else if(strcmp(argv[i], "--threads") == 0 && has_value)
+        {
+            if(!parse_size(argv[++i], &threads))
+            {
+                fprintf(stderr, "Invalid thread count '%s'\n", argv[i]);
+                bad = true;
+            }
+        }
+        else if(strcmp(argv[i], "--cascade") == 0 && has_value)
+            cascade = argv[++i];
+        else if(strcmp(argv[i], "--min-prob") == 0 && has_value)
+            thresholds.min_prob = atof(argv[++i]);
+        else if(strcmp(argv[i], "--min-margin") == 0 && has_value)
+            thresholds.min_margin = atof(argv[++i]);
+        else if(strcmp(argv[i], "--tune") == 0)
+            tune = true;
+        else
+        {
+            fprintf(stderr, "Unknown argument '%s'\n", argv[i]);
+            bad = true;
+        }
+    }
+
+    if(bad || model == NULL || images_path == NULL || labels_path == NULL || (tune && cascade == NULL) || (cascade != NULL && IsFileExtension(model, ".ensemble")))
+    {
+        print_usage();
+        return 1;
+    }
+
+    IdxFile images, labels;
+    if(!open_idx(images_path, &images) || !open_idx(labels_path, &labels))
+    {
+        fprintf(stderr, "Couldn't open the dataset '%s', '%s'\n", images_path, labels_path);
+        close_idx(&images);
+        return 1;
+    }
+
+    if(images.count != labels.count)
+        fprintf(stderr, "The dataset has %zu images and %zu labels, only the first %zu are evaluated\n",
+            images.count, labels.count, min(images.count, labels.count));
+
+    if(IsFileExtension(model, ".ensemble"))
+    {
+        int code = eval_ensemble(model, threads, &images, &labels);
+        close_idx(&images);
+        close_idx(&labels);
+        return code;
+    }
+
+    ReadResult read = read_model(model, GetFileNameWithoutExt(model));
+    if(read.status != SUCCESS)
+    {
+        fprintf(stderr, "Couldn't read the model '%s' (status %d)\n", model, read.status);
+        close_idx(&images);
+        close_idx(&labels);
+        return 1;
+    }
+
+    start_thread_pool(threads);
+
+    int code = cascade == NULL
+        ? eval_single(&read.model, &images, &labels)
+        : eval_cascade(&read.model, cascade, thresholds, tune, &images, &labels);
+
+    stop_thread_pool();
+    free_mlp(&read.model);
+    close_idx(&images);
+    close_idx(&labels);
+
+    return code;
+}
+
+
+int run_cli(int argc, char *argv[])
+{
+    // raylib logs to the standard output, which is reserved for the results
+    SetTraceLogLevel(LOG_NONE);
+
+    if(has_flag(argc, argv, "--eval"))
+        return run_eval(argc, argv);
+    if(has_flag(argc, argv, "--serve"))
+        return run_server(argc, argv);
+    if(has_flag(argc, argv, "--loadgen"))
+        return run_loadgen(argc, argv);
+    if(has_flag(argc, argv, "--replay"))
+        return run_replay(argc, argv);
+
+    return run_infer(argc, argv);
+}
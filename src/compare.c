@@ -0,0 +1,258 @@
+#include "debugmalloc.h"
+#include "compare.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "errors.h"
+#include "filehandler.h"
+#include "forward.h"
+#include "threadpool.h"
+#include "snippets.h"
+#include "stats.h"
+
+
+/** A drawing handed to the compared models. */
+typedef struct Snapshot {
+    unsigned char *pixels;
+    size_t width, height;
+    /** The number of pixels the buffer can hold. */
+    size_t cap;
+} Snapshot;
+
+
+/** A loaded model with its own scratch space. */
+typedef struct Compared {
+    MLP mlp;
+    /** Path the model was read from, used to detect changes of the list. */
+    char *path;
+    InferContext ctx;
+    CompareResult result;
+} Compared;
+
+
+static bool running = false;
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+
+static Compared *models = NULL;
+static size_t model_count = 0;
+
+/** The mailbox, holding the newest request if pending is true. */
+static Snapshot slot = {NULL, 0, 0, 0};
+/** Buffer that the next snapshot is taken into before it's swapped into the slot. */
+static Snapshot staging = {NULL, 0, 0, 0};
+/** Buffer of the request that is currently computed. */
+static Snapshot work = {NULL, 0, 0, 0};
+
+static bool pending = false;
+static bool computing = false;
+static bool stopping = false;
+
+/** Results of the last finished comparison, published under the lock. */
+static CompareResult *latest = NULL;
+static size_t seq = 0;
+
+
+/**
+ * Runs a single model on the current snapshot. Called by the thread pool.
+ * 
+ * \param arg Unused.
+ * \param index Index of the model.
+ */
+static void compare_model(void *arg, size_t index)
+{
+    Compared *m = &models[index];
+    double in[(m->mlp.x/m->mlp.kx) * (m->mlp.y/m->mlp.ky)];
+    double prob[m->ctx.outputs];
+
+    double start = now_seconds();
+    pool_pixels(&m->mlp, work.pixels, work.width, work.height, in);
+    m->result.result = infer_mlp(&m->ctx, in);
+    infer_probabilities(&m->ctx, prob);
+    m->result.latency = now_seconds() - start;
+    m->result.prob = prob[m->result.result];
+}
+
+
+/**
+ * The background thread's main loop.
+ * Takes the newest snapshot out of the mailbox, runs every model on it in parallel and publishes the results.
+ */
+static void* compare_loop(void *arg)
+{
+    pthread_mutex_lock(&lock);
+    while(true)
+    {
+        while(!pending && !stopping)
+            pthread_cond_wait(&wake, &lock);
+
+        if(stopping)
+            break;
+
+        Snapshot t = work;
+        work = slot;
+        slot = t;
+        pending = false;
+        computing = true;
+        pthread_mutex_unlock(&lock);
+
+        run_parallel(compare_model, NULL, model_count);
+
+        pthread_mutex_lock(&lock);
+        for(size_t i = 0; i < model_count; i++)
+            latest[i] = models[i].result;
+        seq++;
+        computing = false;
+    }
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
+
+
+/**
+ * Checks if the loaded models were read from a given list.
+ * 
+ * \param paths Pointer to the Vector of paths.
+ * 
+ * \returns True if every path of the list was loaded, in the same order.
+ */
+static bool same_models(const Vector *paths)
+{
+    size_t loaded = 0;
+    for(size_t i = 0; i < paths->size; i++)
+    {
+        if(loaded == model_count || strcmp(models[loaded].path, get_vector_as_type(paths, i, char*)) != 0)
+            return false;
+        loaded++;
+    }
+
+    return loaded == model_count;
+}
+
+
+void set_compared_models(const Vector *paths, const Vector *names)
+{
+    if(models != NULL && same_models(paths))
+        return;
+
+    stop_comparison();
+
+    models = (Compared*) malloc(max(paths->size, 1) * sizeof(Compared));
+    latest = (CompareResult*) malloc(max(paths->size, 1) * sizeof(CompareResult));
+    if(models == NULL || latest == NULL)
+        exit(ERR_NULLPOINTER);
+
+    // models that can't be read are left out, the load view reports their errors when they are loaded
+    for(size_t i = 0; i < paths->size; i++)
+    {
+        ReadResult read = read_model(get_vector_as_type(paths, i, char*), get_vector_as_type(names, i, char*));
+        if(read.status != SUCCESS)
+            continue;
+
+        Compared *m = &models[model_count++];
+        m->mlp = read.model;
+        m->path = strclone(get_vector_as_type(paths, i, char*));
+        m->ctx = create_infer_context(&m->mlp);
+        m->result = (CompareResult) {m->mlp.name, 0, 0, 0};
+        latest[model_count-1] = m->result;
+    }
+
+    pending = false;
+    computing = false;
+    stopping = false;
+    seq = 0;
+
+    running = pthread_create(&thread, NULL, compare_loop, NULL) == 0;
+}
+
+
+void request_comparison(const MLP *mlp)
+{
+    if(!running || model_count == 0)
+        return;
+
+    // the staging buffer belongs to this thread, so it can be resized
+    size_t size = mlp->x * mlp->y;
+    if(staging.cap < size)
+    {
+        free(staging.pixels);
+        staging.pixels = (unsigned char*) malloc(size);
+        if(staging.pixels == NULL)
+            exit(ERR_NULLPOINTER);
+        staging.cap = size;
+    }
+
+    staging.width = mlp->x;
+    staging.height = mlp->y;
+    canvas_pixels(&mlp->draw_canvas, staging.pixels);
+
+    pthread_mutex_lock(&lock);
+    Snapshot t = slot;
+    slot = staging;
+    staging = t;
+    pending = true;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+}
+
+
+size_t compared_model_count()
+{
+    return model_count;
+}
+
+
+size_t get_comparison(CompareResult *out)
+{
+    pthread_mutex_lock(&lock);
+    memcpy(out, latest, model_count * sizeof(CompareResult));
+    size_t s = seq;
+    pthread_mutex_unlock(&lock);
+
+    return s;
+}
+
+
+bool comparison_busy()
+{
+    pthread_mutex_lock(&lock);
+    bool busy = pending || computing;
+    pthread_mutex_unlock(&lock);
+
+    return busy;
+}
+
+
+void stop_comparison()
+{
+    if(running)
+    {
+        pthread_mutex_lock(&lock);
+        stopping = true;
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&lock);
+
+        pthread_join(thread, NULL);
+        running = false;
+    }
+
+    for(size_t i = 0; i < model_count; i++)
+    {
+        free_infer_context(&models[i].ctx);
+        free_mlp(&models[i].mlp);
+        free(models[i].path);
+    }
+    free(models);
+    free(latest);
+    models = NULL;
+    latest = NULL;
+    model_count = 0;
+
+    free(slot.pixels);
+    free(staging.pixels);
+    free(work.pixels);
+    slot = staging = work = (Snapshot) {NULL, 0, 0, 0};
+}
@@ -0,0 +1,311 @@
+#include "debugmalloc.h"
+#include "ensemble.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "vector.h"
+#include "threadpool.h"
+#include "snippets.h"
+#include "raylib.h"
+
+/** The longest line of a definition. */
+#define ENSEMBLE_LINE 1024
+
+
+/**
+ * Checks if two models pool their inputs the same way.
+ * 
+ * \param a Pointer to the first MLP.
+ * \param b Pointer to the second MLP.
+ * 
+ * \returns True if their Canvas and kernel sizes match.
+ */
+static bool same_input(const MLP *a, const MLP *b)
+{
+    return a->x == b->x && a->y == b->y && a->kx == b->kx && a->ky == b->ky;
+}
+
+
+/**
+ * Creates the buffers of an Ensemble whose members are already read.
+ * 
+ * \param e Pointer to the Ensemble.
+ */
+static void prepare_ensemble(Ensemble *e)
+{
+    e->inputs = (double**) malloc(e->count * sizeof(double*));
+    e->outputs = (double*) malloc(e->count * e->classes * sizeof(double));
+    e->prob = (double*) calloc(e->classes, sizeof(double));
+    if(e->inputs == NULL || e->outputs == NULL || e->prob == NULL)
+        exit(ERR_NULLPOINTER);
+
+    for(size_t i = 0; i < e->count; i++)
+    {
+        Member *m = &e->members[i];
+        m->ctx = create_infer_context(&m->mlp);
+
+        // members with the same Canvas and kernel size share the pooled input of the first one
+        m->input = e->input_count;
+        for(size_t j = 0; j < i; j++)
+        {
+            if(same_input(&e->members[j].mlp, &m->mlp))
+            {
+                m->input = e->members[j].input;
+                break;
+            }
+        }
+
+        if(m->input == e->input_count)
+        {
+            e->inputs[e->input_count] = (double*) malloc((m->mlp.x/m->mlp.kx) * (m->mlp.y/m->mlp.ky) * sizeof(double));
+            if(e->inputs[e->input_count] == NULL)
+                exit(ERR_NULLPOINTER);
+            e->input_count++;
+        }
+    }
+}
+
+
+/**
+ * Resolves the path of a member relative to the definition's directory.
+ * 
+ * \param def Path to the definition.
+ * \param path The path of the member as written in the definition.
+ * 
+ * \returns The resolved path. Like TextFormat(), it's only valid until the next call.
+ */
+static const char* member_path(const char *def, const char *path)
+{
+    bool absolute = path[0] == '/' || path[0] == '\\' || (path[0] != '\0' && path[1] == ':');
+    if(absolute || strpbrk(def, "/\\") == NULL)
+        return TextFormat("%s", path);
+
+    return TextFormat("%s/%s", GetDirectoryPath(def), path);
+}
+
+
+EnsembleRead read_ensemble(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+        return (EnsembleRead) {NOFILE, 0, {0}};
+
+    Ensemble e = {AVERAGE, NULL, 0, 0, NULL, 0, NULL, NULL, 0};
+    Vector members = create_vector(4, sizeof(Member), false);
+    RSTATUS status = SUCCESS;
+    size_t number = 0;
+    char line[ENSEMBLE_LINE];
+
+    while(status == SUCCESS && fgets(line, sizeof(line), f) != NULL)
+    {
+        number++;
+        char first[ENSEMBLE_LINE];
+        char extra;
+        double weight;
+
+        if(sscanf(line, "%s", first) != 1 || first[0] == '#')
+            continue;
+
+        if(strcmp(first, "mode") == 0)
+        {
+            char mode[ENSEMBLE_LINE];
+            if(sscanf(line, "%*s %s %c", mode, &extra) != 1)
+                status = WRONGINSTRUCTION;
+            else if(strcmp(mode, "average") == 0)
+                e.mode = AVERAGE;
+            else if(strcmp(mode, "vote") == 0)
+                e.mode = VOTE;
+            else
+                status = WRONGINSTRUCTION;
+            continue;
+        }
+
+        if(sscanf(line, "%*s %lf %c", &weight, &extra) != 1 || weight < 0)
+        {
+            status = WRONGINSTRUCTION;
+            continue;
+        }
+
+        const char *p = member_path(path, first);
+        ReadResult read = read_model(p, GetFileNameWithoutExt(p));
+        if(read.status != SUCCESS)
+        {
+            status = read.status;
+            continue;
+        }
+
+        // every member has to answer the same question
+        size_t classes = get_vector_as_type(&read.model.layers, read.model.layers.size-1, Vector).size;
+        if(members.size > 0 && classes != e.classes)
+            status = OUTPUTMISMATCH;
+        e.classes = classes;
+
+        Member m = {read.model, weight, {0}, 0};
+        push_vector(&members, &m);
+    }
+    fclose(f);
+
+    if(status == SUCCESS && members.size == 0)
+    {
+        status = NOMODEL;
+        number = 0;
+    }
+
+    if(status != SUCCESS)
+    {
+        for(size_t i = 0; i < members.size; i++)
+            free_mlp(&get_vector_as_type(&members, i, Member).mlp);
+        free_vector(&members);
+        return (EnsembleRead) {status, number, {0}};
+    }
+
+    // the Vector's array is kept as the members' array
+    e.members = (Member*) members.arr;
+    e.count = members.size;
+    prepare_ensemble(&e);
+
+    return (EnsembleRead) {SUCCESS, 0, e};
+}
+
+
+/**
+ * Runs a member on its pooled input. Called by the thread pool.
+ * 
+ * \param arg Pointer to the Ensemble.
+ * \param index Index of the member.
+ */
+static void run_member(void *arg, size_t index)
+{
+    Ensemble *e = (Ensemble*) arg;
+    Member *m = &e->members[index];
+
+    infer_mlp(&m->ctx, e->inputs[m->input]);
+    infer_probabilities(&m->ctx, e->outputs + index*e->classes);
+}
+
+
+size_t run_ensemble(Ensemble *e, const unsigned char *pixels, size_t width, size_t height)
+{
+    size_t pooled = 0;
+    for(size_t i = 0; i < e->count && pooled < e->input_count; i++)
+    {
+        Member *m = &e->members[i];
+        if(m->input == pooled)
+        {
+            pool_pixels(&m->mlp, pixels, width, height, e->inputs[pooled]);
+            pooled++;
+        }
+    }
+
+    run_parallel(run_member, e, e->count);
+
+    double total = 0;
+    for(size_t j = 0; j < e->classes; j++)
+        e->prob[j] = 0;
+
+    for(size_t i = 0; i < e->count; i++)
+    {
+        const double *out = e->outputs + i*e->classes;
+        double w = e->members[i].weight;
+        total += w;
+
+        if(e->mode == AVERAGE)
+        {
+            for(size_t j = 0; j < e->classes; j++)
+                e->prob[j] += w * out[j];
+        }
+        else
+        {
+            size_t vote = 0;
+            for(size_t j = 1; j < e->classes; j++)
+            {
+                if(out[j] > out[vote])
+                    vote = j;
+            }
+            e->prob[vote] += w;
+        }
+    }
+
+    e->result = 0;
+    for(size_t j = 0; j < e->classes; j++)
+    {
+        if(total > 0)
+            e->prob[j] /= total;
+        if(e->prob[j] > e->prob[e->result])
+            e->result = j;
+    }
+
+    return e->result;
+}
+
+
+Member* largest_member(Ensemble *e)
+{
+    Member *largest = &e->members[0];
+    for(size_t i = 1; i < e->count; i++)
+    {
+        if(e->members[i].mlp.x * e->members[i].mlp.y > largest->mlp.x * largest->mlp.y)
+            largest = &e->members[i];
+    }
+
+    return largest;
+}
+
+
+size_t ensemble_topk(const Ensemble *e, size_t k, size_t *out_idx, double *out_prob)
+{
+    return topk(e->prob, e->classes, k, out_idx, out_prob);
+}
+
+
+Evaluation evaluate_ensemble(Ensemble *e, const IdxFile *images, const IdxFile *labels)
+{
+    size_t classes = e->classes;
+    size_t count = min(images->count, labels->count);
+
+    Evaluation eval = {classes, 0, 0, 0, (size_t*) calloc(classes*classes, sizeof(size_t))};
+    if(eval.confusion == NULL)
+        exit(ERR_NULLPOINTER);
+
+    for(size_t i = 0; i < count; i++)
+    {
+        size_t label = *get_idx_item(labels, i);
+        if(label >= classes)
+        {
+            eval.skipped++;
+            continue;
+        }
+
+        size_t predicted = run_ensemble(e, get_idx_item(images, i), images->cols, images->rows);
+        eval.confusion[label*classes + predicted]++;
+        eval.total++;
+        if(predicted == label)
+            eval.correct++;
+    }
+
+    return eval;
+}
+
+
+void free_ensemble(Ensemble *e)
+{
+    for(size_t i = 0; i < e->count; i++)
+    {
+        free_infer_context(&e->members[i].ctx);
+        free_mlp(&e->members[i].mlp);
+    }
+
+    for(size_t i = 0; i < e->input_count; i++)
+        free(e->inputs[i]);
+
+    free(e->inputs);
+    free(e->outputs);
+    free(e->prob);
+    free(e->members);
+    e->members = NULL;
+    e->inputs = NULL;
+    e->outputs = e->prob = NULL;
+    e->count = e->input_count = 0;
+}
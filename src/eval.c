@@ -0,0 +1,156 @@
+#include "debugmalloc.h"
+#include "eval.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "errors.h"
+#include "forward.h"
+#include "threadpool.h"
+
+
+/** A contiguous range of images evaluated by a single task. */
+typedef struct EvalChunk {
+    InferContext ctx;
+    size_t first, last;
+    size_t correct, skipped;
+    /** The chunk's own confusion matrix, so the tasks don't share anything they write. */
+    size_t *confusion;
+} EvalChunk;
+
+
+/** The shared, read-only state of an evaluation. */
+typedef struct EvalJob {
+    const MLP *mlp;
+    const IdxFile *images, *labels;
+    EvalChunk *chunks;
+} EvalJob;
+
+
+/**
+ * Evaluates a chunk of the dataset. Called by the thread pool.
+ * 
+ * \param arg Pointer to the EvalJob.
+ * \param index Index of the chunk.
+ */
+static void eval_chunk(void *arg, size_t index)
+{
+    EvalJob *job = (EvalJob*) arg;
+    EvalChunk *chunk = &job->chunks[index];
+    const MLP *mlp = job->mlp;
+    size_t classes = chunk->ctx.outputs;
+    double in[(mlp->x/mlp->kx) * (mlp->y/mlp->ky)];
+    // the counters are kept local, the neighbouring chunks may share a cache line
+    size_t correct = 0, skipped = 0;
+
+    for(size_t i = chunk->first; i < chunk->last; i++)
+    {
+        size_t label = *get_idx_item(job->labels, i);
+        if(label >= classes)
+        {
+            skipped++;
+            continue;
+        }
+
+        pool_pixels(mlp, get_idx_item(job->images, i), job->images->cols, job->images->rows, in);
+        size_t predicted = infer_mlp(&chunk->ctx, in);
+
+        chunk->confusion[label*classes + predicted]++;
+        if(predicted == label)
+            correct++;
+    }
+
+    chunk->correct = correct;
+    chunk->skipped = skipped;
+}
+
+
+Evaluation evaluate_mlp(const MLP *mlp, const IdxFile *images, const IdxFile *labels)
+{
+    size_t classes = get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector).size;
+    size_t count = images->count < labels->count ? images->count : labels->count;
+
+    Evaluation eval = {classes, 0, 0, 0, (size_t*) calloc(classes*classes, sizeof(size_t))};
+    if(eval.confusion == NULL)
+        exit(ERR_NULLPOINTER);
+
+    // a few chunks per thread, so a slower thread doesn't hold up the others
+    size_t n = thread_pool_size() * 4;
+    if(n > count)
+        n = count > 0 ? count : 1;
+
+    // everything is allocated here, because the workers mustn't use debugmalloc
+    EvalChunk *chunks = (EvalChunk*) malloc(n * sizeof(EvalChunk));
+    if(chunks == NULL)
+        exit(ERR_NULLPOINTER);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        chunks[i] = (EvalChunk) {create_infer_context(mlp), count*i/n, count*(i+1)/n, 0, 0, (size_t*) calloc(classes*classes, sizeof(size_t))};
+        if(chunks[i].confusion == NULL)
+            exit(ERR_NULLPOINTER);
+    }
+
+    EvalJob job = {mlp, images, labels, chunks};
+    run_parallel(eval_chunk, &job, n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        eval.correct += chunks[i].correct;
+        eval.skipped += chunks[i].skipped;
+        for(size_t j = 0; j < classes*classes; j++)
+            eval.confusion[j] += chunks[i].confusion[j];
+
+        free(chunks[i].confusion);
+        free_infer_context(&chunks[i].ctx);
+    }
+    free(chunks);
+
+    eval.total = count - eval.skipped;
+
+    return eval;
+}
+
+
+void print_evaluation(FILE *f, const Evaluation *eval)
+{
+    size_t classes = eval->classes;
+
+    fprintf(f, "Accuracy: %.2lf%% (%zu/%zu)\n", eval->total > 0 ? 100.0*eval->correct/eval->total : 0, eval->correct, eval->total);
+    if(eval->skipped > 0)
+        fprintf(f, "Skipped: %zu images with unknown labels\n", eval->skipped);
+
+    fprintf(f, "\nClass  Precision  Recall  Support\n");
+    for(size_t i = 0; i < classes; i++)
+    {
+        size_t hit = eval->confusion[i*classes + i];
+        size_t predicted = 0, actual = 0;
+        for(size_t j = 0; j < classes; j++)
+        {
+            predicted += eval->confusion[j*classes + i];
+            actual += eval->confusion[i*classes + j];
+        }
+
+        fprintf(f, "%5zu  %8.2lf%%  %5.2lf%%  %7zu\n", i,
+            predicted > 0 ? 100.0*hit/predicted : 0, actual > 0 ? 100.0*hit/actual : 0, actual);
+    }
+
+    fprintf(f, "\nConfusion matrix (rows: label, columns: prediction)\n      ");
+    for(size_t j = 0; j < classes; j++)
+        fprintf(f, "%7zu", j);
+    fprintf(f, "\n");
+
+    for(size_t i = 0; i < classes; i++)
+    {
+        fprintf(f, "%5zu ", i);
+        for(size_t j = 0; j < classes; j++)
+            fprintf(f, "%7zu", eval->confusion[i*classes + j]);
+        fprintf(f, "\n");
+    }
+}
+
+
+void free_evaluation(Evaluation *eval)
+{
+    free(eval->confusion);
+    eval->confusion = NULL;
+}
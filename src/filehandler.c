@@ -162,49 +162,42 @@ ReadResult read_model(const char *path, const char *name)
 }
 
 
+void print_result(FILE *f, const double *prob, size_t size, size_t result)
+{
+    for(size_t i = 0; i < size; i++)
+        fprintf(f, "%zu: %.2lf%% ", i, prob[i]*100);
+
+    fprintf(f, "\nScore: %zu\n", result);
+}
+
+
 bool write_model_result(MLP *mlp, WRITEMODE mode)
 {
-    FILE *file = NULL;
-    char *fname = NULL;
+    size_t result;
+    double prob;
+    mlp_topk(mlp, 1, &result, &prob);
+
+    Vector *v = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
+    double probs[v->size];
+    for(size_t i = 0; i < v->size; i++)
+        probs[i] = get_vector_as_type(v, i, Node).output;
+
     if(mode == DISK || mode == ALL)
     {
-        fname = (char*) malloc(strlen(mlp->name)+5);
+        char fname[strlen(mlp->name)+5];
         strcpy(fname, mlp->name);
         strcat(fname, ".txt");
 
-        file = fopen((const char*) fname, "w");
+        FILE *file = fopen((const char*) fname, "w");
         if(file == NULL)
             return false;
-    }
-
-    Vector *v = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
-    Node *n = &get_vector_as_type(v, 0, Node);
 
-    size_t mind = 0;
-    double ma = n->output;
-    for(size_t i = 0; i < v->size; i++)
-    {
-        n = &get_vector_as_type(v, i, Node);
-        if(mode == DISK || mode == ALL)
-            fprintf(file, "%zu: %.2lf%% ", i, n->output*100);
-        if(mode == CONSOLE || mode == ALL)
-            printf("%zu: %.2lf%% ", i, n->output*100);
-        
-        if(n->output >= ma) {
-            ma = n->output; mind = i;
-        }
-    }
-
-    mlp->result = mind;
-    
-    if(mode == DISK || mode == ALL)
-    {
-        fprintf(file, "\nScore: %zu\n", mind);
-        free(fname);
+        print_result(file, probs, v->size, result);
         fclose(file);
     }
+
     if(mode == CONSOLE || mode == ALL)
-        printf("\nScore: %zu\n", mind);
+        print_result(stdout, probs, v->size, result);
 
     return true;
 }
@@ -0,0 +1,132 @@
+#include "debugmalloc.h"
+#include "forward.h"
+#include <stdlib.h>
+
+#include "errors.h"
+#include "snippets.h"
+
+
+InferContext create_infer_context(const MLP *mlp)
+{
+    return create_batch_context(mlp, 1);
+}
+
+
+InferContext create_batch_context(const MLP *mlp, size_t capacity)
+{
+    size_t width = 0;
+    for(size_t i = 0; i < mlp->layers.size; i++)
+        width = max(width, get_vector_as_type(&mlp->layers, i, Vector).size);
+
+    double *a = (double*) malloc(2 * capacity * width * sizeof(double));
+    if(a == NULL)
+        exit(ERR_NULLPOINTER);
+
+    InferContext ctx = {mlp, width, capacity, a, a + capacity*width, a, get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector).size};
+    return ctx;
+}
+
+
+void free_infer_context(InferContext *ctx)
+{
+    // the two buffers share a single allocation
+    free(ctx->a);
+    ctx->a = ctx->b = NULL;
+    ctx->output = NULL;
+}
+
+
+size_t infer_mlp(InferContext *ctx, const double *in)
+{
+    size_t result;
+    infer_mlp_batch(ctx, in, 1, &result);
+
+    return result;
+}
+
+
+void infer_mlp_batch(InferContext *ctx, const double *in, size_t n, size_t *results)
+{
+    const Vector *layers = &ctx->mlp->layers;
+    size_t width = ctx->width;
+    double *curr = ctx->a;
+    double *next = ctx->b;
+
+    const Vector *input = &get_vector_as_type(layers, 0, Vector);
+    const Node *nodes = (const Node*) input->arr;
+    for(size_t b = 0; b < n; b++)
+    {
+        for(size_t i = 0; i < input->size; i++)
+            curr[b*width + i] = nodes[i].act(in[b*input->size + i] + nodes[i].bias);
+    }
+
+    for(size_t l = 1; l < layers->size; l++)
+    {
+        const Vector *prev = &get_vector_as_type(layers, l-1, Vector);
+        const Vector *layer = &get_vector_as_type(layers, l, Vector);
+        const Node *sources = (const Node*) prev->arr;
+        size_t size = layer->size;
+
+        for(size_t b = 0; b < n; b++)
+        {
+            for(size_t j = 0; j < size; j++)
+                next[b*width + j] = 0;
+        }
+
+        // every source Node's outgoing weights are contiguous, so they are accumulated source by source,
+        // skipping the silent ones, which is most of the input pixels of a drawing.
+        // The weights of a source stay in the cache while they are applied to every input of the batch.
+        for(size_t i = 0; i < prev->size; i++)
+        {
+            const double *w = (const double*) sources[i].con.arr;
+            for(size_t b = 0; b < n; b++)
+            {
+                double o = curr[b*width + i];
+                if(o == 0)
+                    continue;
+
+                double *dst = next + b*width;
+                for(size_t j = 0; j < size; j++)
+                    dst[j] += o * w[j];
+            }
+        }
+
+        nodes = (const Node*) layer->arr;
+        for(size_t b = 0; b < n; b++)
+        {
+            double *dst = next + b*width;
+            for(size_t j = 0; j < size; j++)
+                dst[j] = nodes[j].act(dst[j] + nodes[j].bias);
+        }
+
+        double *t = curr;
+        curr = next;
+        next = t;
+    }
+
+    ctx->output = curr;
+
+    for(size_t b = 0; b < n; b++)
+    {
+        const double *out = curr + b*width;
+        size_t ind = 0;
+        for(size_t i = 1; i < ctx->outputs; i++)
+        {
+            if(out[i] > out[ind])
+                ind = i;
+        }
+        results[b] = ind;
+    }
+}
+
+
+void infer_probabilities(const InferContext *ctx, double *out)
+{
+    infer_batch_probabilities(ctx, 0, out);
+}
+
+
+void infer_batch_probabilities(const InferContext *ctx, size_t n, double *out)
+{
+    softmax(ctx->output + n*ctx->width, ctx->outputs, out);
+}
@@ -3,13 +3,22 @@
 #include <stdbool.h>
 #include <math.h>
 
+#include "errors.h"
 #include "vector.h"
 #include "mlp.h"
 #include "filehandler.h"
+#include "brush.h"
+#include "layout.h"
+#include "labels.h"
+#include "heatmap.h"
+#include "inference.h"
+#include "compare.h"
+#include "recorder.h"
 #include "snippets.h"
 
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
 
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
@@ -18,6 +27,13 @@
 #define GUI_WINDOW_FILE_DIALOG_IMPLEMENTATION
 #include "gui_window_file_dialog.h"
 
+/** Below this zoom level the weight labels aren't drawn. */
+#define LOD_LABELS 0.4f
+/** Below this zoom level each layer is drawn as a single activation strip instead of circles. */
+#define LOD_CIRCLES 0.1f
+/** Size of a receptive field atlas pixel on the explore view's 2D plane. */
+#define HEATMAP_SCALE 10
+
 
 static bool dialog_ready = false;
 static GuiWindowFileDialogState file_dialog;
@@ -25,6 +41,50 @@ static GuiWindowFileDialogState file_dialog;
 static char *message = NULL;
 static char *title = NULL;
 
+/** Texture mirroring the drawing Canvas, drawn scaled up in a single call. */
+static Texture2D board = {0};
+/** Buffer for packing the changed pixels of the drawing Canvas before uploading them. */
+static unsigned char *board_pixels = NULL;
+/** True if the whole texture has to be uploaded, because a new model was loaded. */
+static bool board_stale = true;
+/** Layout of the explore view, recomputed when a new model is loaded. */
+static Layout layout = {0};
+static bool layout_stale = true;
+
+/** Per-layer activation strips for the farthest zoom level, rebuilt after every run of the model. */
+static Vector strips = {NULL, sizeof(Texture2D), 0, 0};
+static size_t strips_runs = 0;
+
+/** A vertex of the selected Node's connection lines. */
+typedef struct LineVertex {
+    Vector2 pos;
+    Color color;
+} LineVertex;
+
+/** Starting vertices of the selected Node's connection lines, rebuilt when the selection changes. */
+static struct {
+    long long layer;
+    size_t node;
+    Vector vertices;
+} lines = {-1, 0, {NULL, sizeof(LineVertex), 0, 0}};
+
+/** The static parts of the explore view, rendered again only when the camera or the model's outputs change. */
+static RenderTexture2D backdrop = {0};
+static Camera2D backdrop_camera = {0};
+static size_t backdrop_runs = 0;
+static bool backdrop_stale = true;
+
+/** Receptive fields of the first hidden layer, built right after a model is loaded. */
+static Heatmap heatmap = {0};
+static Texture2D heatmap_texture = {0};
+
+/** Texture of the brush preview, drawn over the board at the cursor. */
+static Texture2D overlay = {0};
+/** The brush settings the overlay was made for. */
+static struct { TOOL tool; bool eraser; int radius; } overlay_brush = {BRUSH, false, 0};
+/** The area of the drawing Canvas that changed since the last upload. Empty if x1 >= x2. */
+static struct { size_t x1, y1, x2, y2; } dirty = {0, 0, 0, 0};
+
 
 /**
  * Creates a Rectangle with a given width and height that's centered on the screen.
@@ -104,8 +164,23 @@ GUISTATE show_load_gui(Vector *paths, Vector *names, MLP *mlp)
                 message = "Invalid instruction found!";
                 break;
             default:
+                stop_inference_worker();
                 free_mlp(mlp);
                 *mlp = read.model;
+                // the new model starts with blank Canvases, a replay has to drop the old strokes too
+                record_event(CLEAR);
+                start_inference_worker(mlp);
+                set_compared_models(paths, names);
+                request_comparison(mlp);
+                board_stale = true;
+                layout_stale = true;
+
+                free_heatmap(&heatmap);
+                heatmap = create_heatmap(mlp);
+                if(heatmap_texture.id != 0)
+                    UnloadTexture(heatmap_texture);
+                heatmap_texture = (Texture2D) {0};
+
                 return DRAWING;
         }
     }
@@ -173,55 +248,138 @@ GUISTATE show_load_gui(Vector *paths, Vector *names, MLP *mlp)
 }
 
 
-typedef enum TOOL {
-    BRUSH,
-    PENCIL
-} TOOL;
+/**
+ * Extends the area of the drawing Canvas that should be uploaded to the texture.
+ * The area is given by its corners and clipped to the Canvas.
+ * 
+ * \param mlp Pointer to the MLP that contains the drawing Canvas.
+ * \param x1 X coordinate of the top left corner.
+ * \param y1 Y coordinate of the top left corner.
+ * \param x2 X coordinate of the bottom right corner, exclusive.
+ * \param y2 Y coordinate of the bottom right corner, exclusive.
+ */
+static void mark_dirty(MLP *mlp, long long x1, long long y1, long long x2, long long y2)
+{
+    x1 = max(x1, 0); y1 = max(y1, 0);
+    x2 = min(x2, (long long) mlp->x); y2 = min(y2, (long long) mlp->y);
+    if(x1 >= x2 || y1 >= y2)
+        return;
 
-typedef enum DRAWMODE {
-    NORMAL,
-    PREVIEW,
-    PREVIEW_UNDO
-} DRAWMODE;
+    if(dirty.x1 >= dirty.x2)
+    {
+        dirty.x1 = x1; dirty.y1 = y1;
+        dirty.x2 = x2; dirty.y2 = y2;
+        return;
+    }
+
+    dirty.x1 = min(dirty.x1, (size_t) x1); dirty.y1 = min(dirty.y1, (size_t) y1);
+    dirty.x2 = max(dirty.x2, (size_t) x2); dirty.y2 = max(dirty.y2, (size_t) y2);
+}
 
 
 /**
- * Draws the brush at the cursor's current position with a given radius.
+ * Uploads the changed area of the drawing Canvas to the board texture.
+ * The texture is recreated if a new model was loaded.
  * 
- * \param mlp Pointer to the MLP that contains the two Canvases used by this function.
- * \param pos The cursor's position on the Canvas.
- * \param tool BRUSH or PENCIL
- * \param eraser Is the eraser enabled?
- * \param radius The radius of the brush.
- * \param undo If true, it resets the current values on the Canvas to their previous value.
+ * \param mlp Pointer to the MLP that contains the drawing Canvas.
  */
-static void draw_brush(MLP *mlp, Vector2 *pos, TOOL tool, bool eraser, int radius, bool undo)
+static void update_board_texture(MLP *mlp)
 {
-    for(size_t i = pos->x-radius+1; i != pos->x+radius; i++)
+    if(board_stale)
     {
-        if(i >= mlp->x) continue;
+        if(board.id != 0)
+            UnloadTexture(board);
+        free(board_pixels);
+
+        board_pixels = calloc(mlp->x * mlp->y * 2, sizeof(unsigned char));
+        if(board_pixels == NULL)
+            exit(ERR_NULLPOINTER);
 
-        for(size_t j = pos->y-radius+1; j != pos->y+radius; j++)
+        Image img = {board_pixels, mlp->x, mlp->y, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+        board = LoadTextureFromImage(img);
+        SetTextureFilter(board, TEXTURE_FILTER_POINT);
+
+        board_stale = false;
+        dirty.x1 = 0; dirty.y1 = 0;
+        dirty.x2 = mlp->x; dirty.y2 = mlp->y;
+    }
+
+    if(dirty.x1 >= dirty.x2)
+        return;
+
+    size_t w = dirty.x2 - dirty.x1;
+    size_t h = dirty.y2 - dirty.y1;
+    unsigned char *p = board_pixels;
+    for(size_t j = dirty.y1; j < dirty.y2; j++)
+    {
+        for(size_t i = dirty.x1; i < dirty.x2; i++)
         {
-            if(j >= mlp->y) continue;
+            *p++ = 0;
+            *p++ = (unsigned char) get_canvas_xy(&mlp->draw_canvas, i, j);
+        }
+    }
+
+    UpdateTextureRec(board, (Rectangle) {dirty.x1, dirty.y1, w, h}, board_pixels);
+    dirty.x1 = dirty.x2 = 0;
+}
+
+
+/**
+ * Recreates the brush preview texture if the brush settings changed.
+ * The preview is black where the brush would draw and white where it would erase,
+ * with the brush's intensity as its alpha.
+ * 
+ * \param tool BRUSH or PENCIL
+ * \param eraser Is the eraser enabled?
+ * \param radius The radius of the brush.
+ */
+static void update_overlay_texture(TOOL tool, bool eraser, int radius)
+{
+    if(overlay.id != 0 && overlay_brush.tool == tool && overlay_brush.eraser == eraser && overlay_brush.radius == radius)
+        return;
 
-            double dist = distance(pos->x, pos->y, i, j);
-            if(dist > radius)
-                continue;
+    if(overlay.id != 0)
+        UnloadTexture(overlay);
 
-            double prev = get_canvas_xy(&mlp->canvas, i, j);
-            double curr = get_canvas_xy(&mlp->draw_canvas, i, j);
-            double change = 255 * ((radius-dist)/radius);
+    int side = 2*radius-1;
+    const double *stamp = get_brush_stamp(radius);
+    unsigned char *pixels = malloc(side * side * 2 * sizeof(unsigned char));
+    if(pixels == NULL)
+        exit(ERR_NULLPOINTER);
 
-            curr = undo ? prev : (tool == BRUSH) ? (eraser ? max(min(prev-change, curr), 0) : min(max(prev+change, curr), 255)) : (eraser ? 0 : 255);
-            set_canvas_xy(&mlp->draw_canvas, i, j, curr);
+    // the stamp is column-major, the texture is row-major
+    for(int j = 0; j < side; j++)
+    {
+        for(int i = 0; i < side; i++)
+        {
+            double weight = stamp[i*side + j];
+            unsigned char *p = &pixels[(j*side + i)*2];
+            p[0] = eraser ? 255 : 0;
+            p[1] = weight < 0 ? 0 : (tool == PENCIL ? 255 : 255*weight);
         }
     }
+
+    Image img = {pixels, side, side, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+    overlay = LoadTextureFromImage(img);
+    SetTextureFilter(overlay, TEXTURE_FILTER_POINT);
+    free(pixels);
+
+    overlay_brush.tool = tool;
+    overlay_brush.eraser = eraser;
+    overlay_brush.radius = radius;
 }
 
 
+typedef enum DRAWMODE {
+    NORMAL,
+    PREVIEW,
+    PREVIEW_UNDO
+} DRAWMODE;
+
+
 /**
  * Draws the drawing board on the screen and handles its functionality.
+ * The brush preview is drawn as an overlay, only real strokes change the drawing Canvas.
  * 
  * \param mlp Pointer to the MLP that contains the Canvas.
  * \param mouse The cursor's current position on the Canvas.
@@ -230,37 +388,57 @@ static void draw_brush(MLP *mlp, Vector2 *pos, TOOL tool, bool eraser, int radiu
  * \param tool The current tool. BRUSH or PENCIL
  * \param eraser Is the eraser enabled?
  * \param radius The radius of the current brush.
+ * 
+ * \returns True if the drawing Canvas was changed.
  */
-static void draw_board_grid(MLP *mlp, Vector2 *mouse, Vector2 *prevmouse, Vector2 toolbox, TOOL tool, bool eraser, int radius)
+static bool draw_board_grid(MLP *mlp, Vector2 *mouse, Vector2 *prevmouse, Vector2 toolbox, TOOL tool, bool eraser, int radius)
 {
     int cellsize = 400/max(mlp->x, mlp->y);
     int offset_x = (400 - cellsize*mlp->x)/2.0;
     int offset_y = (400 - cellsize*mlp->y)/2.0;
+    Rectangle area = {toolbox.x-410+offset_x, toolbox.y+offset_y, mlp->x*cellsize, mlp->y*cellsize};
     
-    GuiGrid((Rectangle) {toolbox.x-410+offset_x, toolbox.y+offset_y, mlp->x*cellsize, mlp->y*cellsize},
-            "", cellsize, 1, mouse, GuiGetStyle(DEFAULT, cellsize > 4 ? LINE_COLOR : BACKGROUND_COLOR));
+    GuiGrid(area, "", cellsize, 1, mouse, GuiGetStyle(DEFAULT, cellsize > 4 ? LINE_COLOR : BACKGROUND_COLOR));
 
-    if(!Vector2Equals(*mouse, (Vector2) {-1, -1}))
-        draw_brush(mlp, mouse, tool, eraser, radius, false);
+    bool changed = false;
+    bool hover = !Vector2Equals(*mouse, (Vector2) {-1, -1});
 
-    Canvas *canv = &(mlp->draw_canvas);
-    for(size_t i = 0; i < mlp->x; i++)
+    if(hover && IsMouseButtonDown(MOUSE_BUTTON_LEFT))
     {
-        for(size_t j = 0; j < mlp->y; j++)
+        // a new stroke starts with a single stamp, otherwise the segment from the last drawn position is stamped
+        bool start = IsMouseButtonPressed(MOUSE_BUTTON_LEFT) || Vector2Equals(*prevmouse, (Vector2) {-1, -1});
+        Vector2 *from = start ? mouse : prevmouse;
+
+        if(start || !Vector2Equals(*from, *mouse))
         {
-            double d = (int) get_canvas_xy(canv, i, j);
-            DrawRectangle(toolbox.x-410+offset_x + i*cellsize, toolbox.y+offset_y + j*cellsize, cellsize, cellsize,
-                (Color) {0, 0, 0, d});
+            mark_dirty(mlp, min(from->x, mouse->x)-radius+1, min(from->y, mouse->y)-radius+1,
+                max(from->x, mouse->x)+radius, max(from->y, mouse->y)+radius);
+            draw_stroke(mlp, from, mouse, tool, eraser, radius);
+            record_stroke(mlp, *from, *mouse, tool, eraser, radius);
+            changed = true;
         }
     }
 
-    if(!Vector2Equals(*mouse, (Vector2) {-1, -1}))
+    update_board_texture(mlp);
+    DrawTexturePro(board, (Rectangle) {0, 0, mlp->x, mlp->y}, area, (Vector2) {0, 0}, 0, WHITE);
+
+    if(hover)
     {
-        if(!IsMouseButtonDown(MOUSE_BUTTON_LEFT) && !IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
-            draw_brush(mlp, mouse, PENCIL, true, radius, true);
+        if(!IsMouseButtonDown(MOUSE_BUTTON_LEFT))
+        {
+            update_overlay_texture(tool, eraser, radius);
+
+            BeginScissorMode(area.x, area.y, area.width, area.height);
+            DrawTexturePro(overlay, (Rectangle) {0, 0, overlay.width, overlay.height},
+                (Rectangle) {area.x + (mouse->x-radius+1)*cellsize, area.y + (mouse->y-radius+1)*cellsize, overlay.width*cellsize, overlay.height*cellsize},
+                (Vector2) {0, 0}, 0, WHITE);
+            EndScissorMode();
+        }
         
-        DrawCircleLines(toolbox.x-410+offset_x + mouse->x*cellsize + cellsize/2.0, toolbox.y+offset_y + mouse->y*cellsize + cellsize/2.0, (radius-1)*cellsize, RED);
+        DrawCircleLines(area.x + mouse->x*cellsize + cellsize/2.0, area.y + mouse->y*cellsize + cellsize/2.0, (radius-1)*cellsize, RED);
     }
+
+    return changed;
 }
 
 
@@ -287,30 +465,27 @@ GUISTATE show_draw_gui(MLP *mlp)
     //  DRAWING BOARD
     // ---------------
     GuiGroupBox((Rectangle) {toolbox.x-410, toolbox.y, 400, 400}, "Drawing Board");
-    draw_board_grid(mlp, &mouse, &prevmouse, toolbox, tool, eraser, bsize_int);
+    bool changed = draw_board_grid(mlp, &mouse, &prevmouse, toolbox, tool, eraser, bsize_int);
 
-    if(IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    if(IsMouseButtonPressed(MOUSE_BUTTON_LEFT) || Vector2Equals(mouse, (Vector2) {-1, -1}))
     {
         prevmouse = (Vector2) {-1, -1};
     }
 
     if(IsMouseButtonReleased(MOUSE_BUTTON_LEFT))
     {
-        Canvas *canv1 = &(mlp->canvas);
-        Canvas *canv2 = &(mlp->draw_canvas);
-
-        for(size_t i = 0; i < mlp->x; i++)
-            for(size_t j = 0; j < mlp->y; j++)
-                set_canvas_xy(canv1, i, j, get_canvas_xy(canv2, i, j));
+        end_stroke(mlp);
+        record_event(RELEASE);
     }
     
-    if(IsMouseButtonDown(MOUSE_BUTTON_LEFT) && !Vector2Equals(mouse, (Vector2) {-1, -1}) && !Vector2Equals(mouse, prevmouse))
-    {
+    if(IsMouseButtonDown(MOUSE_BUTTON_LEFT) && !Vector2Equals(mouse, (Vector2) {-1, -1}))
         prevmouse = mouse;
-        load_mlp_input(mlp);
-        run_mlp(mlp);
 
-        write_model_result(mlp, CONSOLE);
+    // hovering doesn't touch the drawing Canvas, so only real strokes need a new result
+    if(changed)
+    {
+        request_inference();
+        request_comparison(mlp);
     }
 
 
@@ -322,8 +497,31 @@ GUISTATE show_draw_gui(MLP *mlp)
     GuiLabel((Rectangle) {toolbox.x+225, toolbox.y+10+15, 200, 10}, TextFormat("Canvas size: %zux%zu", mlp->x, mlp->y));
     GuiLabel((Rectangle) {toolbox.x+225, toolbox.y+10+30, 200, 10}, TextFormat("MaxPool2D kernel size: %zux%zu", mlp->kx, mlp->ky));
     GuiLabel((Rectangle) {toolbox.x+225, toolbox.y+10+45, 200, 10}, TextFormat("Layer count: %zu", mlp->layers.size));
-    double perc = get_vector_as_type(&get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector), mlp->result, Node).output;
-    GuiLabel((Rectangle) {toolbox.x+225, toolbox.y+10+60, 200, 10}, TextFormat("Result: %zu (%.2lf%%)", mlp->result, perc*100));
+    InferenceResult res = get_inference_result();
+    GuiLabel((Rectangle) {toolbox.x+225, toolbox.y+10+60, 200, 10}, TextFormat("Result: %zu (%.2lf%%)", res.result, res.prob*100));
+
+
+    // -----------------
+    //  COMPARED MODELS
+    // -----------------
+    size_t compared = compared_model_count();
+    if(compared > 0)
+    {
+        // as many rows as fit next to the drawing board
+        size_t rows = min(compared, (size_t) 18);
+        CompareResult results[compared];
+        size_t runs = get_comparison(results);
+
+        GuiGroupBox((Rectangle) {toolbox.x+215, toolbox.y+100, 200, 20 + 15*rows}, "Compared models");
+        for(size_t i = 0; i < rows; i++)
+        {
+            Rectangle r = {toolbox.x+225, toolbox.y+110 + 15*i, 190, 10};
+            if(runs == 0)
+                GuiLabel(r, TextFormat("%.12s: -", results[i].name));
+            else
+                GuiLabel(r, TextFormat("%.12s: %zu (%.1lf%%) %.0lfus", results[i].name, results[i].result, results[i].prob*100, results[i].latency*1e6));
+        }
+    }
 
 
     // --------------
@@ -358,6 +556,10 @@ GUISTATE show_draw_gui(MLP *mlp)
     {
         clear_canvas(&mlp->canvas);
         clear_canvas(&mlp->draw_canvas);
+        mark_dirty(mlp, 0, 0, mlp->x, mlp->y);
+        record_event(CLEAR);
+        request_inference();
+        request_comparison(mlp);
     }
 
     // Brush size control
@@ -387,25 +589,29 @@ GUISTATE show_draw_gui(MLP *mlp)
     //  STATE SWITCH
     // --------------
     if(GuiButton((Rectangle) {toolbox.x+10, toolbox.y+370, 75, 30}, "Explore"))
+    {
+        // the explore view reads the nodes directly
+        sync_inference_worker();
         return SIMULATION;
+    }
 
     return IsKeyPressed(KEY_ESCAPE) ? LOADING : DRAWING;
 }
 
 
 /**
- * Checks if a position is visible by a given Camera2D.
+ * Calculates the area of the 2D plane that is visible by a given Camera2D.
  * 
- * \param pos The position.
  * \param camera The camera.
  * 
- * \returns False if the position is off-screen, true if it's visible.
+ * \returns The visible Rectangle on the 2D plane.
  */
-static bool visible(Vector2 pos, Camera2D camera)
+static Rectangle camera_view(Camera2D camera)
 {
-    Vector2 scr = GetWorldToScreen2D(pos, camera);
+    Vector2 tl = GetScreenToWorld2D((Vector2) {0, 0}, camera);
+    Vector2 br = GetScreenToWorld2D((Vector2) {GetScreenWidth(), GetScreenHeight()}, camera);
 
-    return scr.x >= 0 && scr.x <= GetScreenWidth() && scr.y >= 0 && scr.y <= GetScreenHeight();
+    return (Rectangle) {tl.x, tl.y, br.x - tl.x, br.y - tl.y};
 }
 
 
@@ -426,54 +632,210 @@ static void draw_node_info(Node n, Camera2D camera)
     DrawRectangle(pos.x, pos.y-size.y, size.x, size.y, WHITE);
     DrawRectangleLines(pos.x, pos.y-size.y, size.x, size.y, SKYBLUE);
 
-    GuiLabel((Rectangle) {pos.x+10, pos.y-size.y+10, size.x, 10}, TextFormat("Value: %lf", n.value));
-    GuiLabel((Rectangle) {pos.x+10, pos.y-size.y+20, size.x, 10}, TextFormat("Bias: %lf", n.bias));
-    GuiLabel((Rectangle) {pos.x+10, pos.y-size.y+30, size.x, 10}, TextFormat("Output: %lf", n.output));
+    float font = GuiGetStyle(DEFAULT, TEXT_SIZE);
+    float spacing = GuiGetStyle(DEFAULT, TEXT_SPACING);
+    GuiLabel((Rectangle) {pos.x+10, pos.y-size.y+10, size.x, 10}, get_label("Value: %lf", n.value, font, spacing).text);
+    GuiLabel((Rectangle) {pos.x+10, pos.y-size.y+20, size.x, 10}, get_label("Bias: %lf", n.bias, font, spacing).text);
+    GuiLabel((Rectangle) {pos.x+10, pos.y-size.y+30, size.x, 10}, get_label("Output: %lf", n.output, font, spacing).text);
 
     BeginMode2D(camera);
 }
 
 
 /**
- * Draws a layer and its connections to a target on-screen.
+ * Frees the activation strip textures.
+ */
+static void unload_strips()
+{
+    for(size_t i = 0; i < strips.size; i++)
+        UnloadTexture(get_vector_as_type(&strips, i, Texture2D));
+
+    free_vector(&strips);
+    strips.size = 0;
+}
+
+
+/**
+ * Rebuilds the activation strips if the model was run since they were made.
+ * Each strip is a one pixel wide texture with a pixel for every Node of the layer,
+ * the outputs are normalized inside the layer.
  * 
- * \param layer Pointer to the layer to draw.
- * \param target Pointer to the target layer. Can be NULL if no target is selected.
- * \param target_index The target Node's index inside the target layer. Irrelevant if the target layer is NULL.
- * \param center A center point for calculating coordinates on the 2D plane.
- * \param offset The offset on the X axis to draw the current layer at.
- * \param camera Pointer to the current camera.
- * \param mouse The cursor's current position on the 2D plane. Not to be confused with the cursor's position on the screen.
+ * \param mlp Pointer to the MLP.
  */
-static void draw_layer(Vector *layer, Vector2 *target, size_t target_index, Vector2 center, int offset, Camera2D *camera, Vector2 mouse)
+static void update_strips(MLP *mlp)
 {
-    for(long long j = 0; j < layer->size; j++)
+    if(strips.arr != NULL && strips_runs == mlp->runs)
+        return;
+
+    unload_strips();
+    strips = create_vector(mlp->layers.size, sizeof(Texture2D), false);
+    strips_runs = mlp->runs;
+
+    for(size_t i = 0; i < mlp->layers.size; i++)
     {
-        Vector2 circle = {center.x + offset, center.y + (j-layer->size/2.0)*100};
-        
-        if(target != NULL)
-            DrawLine(circle.x, circle.y, target->x, target->y, RED);
-        
-        if(visible(circle, *camera))
+        Vector *layer = &get_vector_as_type(&mlp->layers, i, Vector);
+        Node *nodes = (Node*) layer->arr;
+
+        double lo = 0, hi = 0;
+        for(size_t j = 0; j < layer->size; j++)
         {
-            DrawCircle(circle.x, circle.y, 30, BLUE);
-            if(target != NULL)
-            {
-                Node *node = &get_vector_as_type(layer, j, Node);
-                double weight = get_vector_as_type(&node->con, target_index, double);
+            lo = min(lo, nodes[j].output);
+            hi = max(hi, nodes[j].output);
+        }
 
-                const char *str = TextFormat("%.4lf", weight);
-                Font f = GetFontDefault();
-                Vector2 strsize = MeasureTextEx(f, str, 10, 2);
+        Color *pixels = malloc(layer->size * sizeof(Color));
+        if(pixels == NULL)
+            exit(ERR_NULLPOINTER);
 
-                Vector2 box = {circle.x - strsize.x/2.0, circle.y - strsize.y/2.0};
-                DrawRectangle(box.x-4, box.y-2, strsize.x+8, strsize.y+3, DARKBLUE);
-                DrawTextEx(GetFontDefault(), str, box, 10, 2, RAYWHITE);
-            }
+        for(size_t j = 0; j < layer->size; j++)
+        {
+            float t = hi > lo ? (nodes[j].output - lo)/(hi - lo) : 0;
+            pixels[j] = (Color) {
+                SKYBLUE.r + (DARKBLUE.r - SKYBLUE.r)*t,
+                SKYBLUE.g + (DARKBLUE.g - SKYBLUE.g)*t,
+                SKYBLUE.b + (DARKBLUE.b - SKYBLUE.b)*t,
+                255
+            };
         }
-        
-        if(CheckCollisionPointCircle(mouse, circle, 30))
-            draw_node_info(get_vector_as_type(layer, j, Node), *camera);
+
+        Image img = {pixels, 1, layer->size, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        Texture2D tex = LoadTextureFromImage(img);
+        SetTextureFilter(tex, TEXTURE_FILTER_POINT);
+        push_vector(&strips, &tex);
+        free(pixels);
+    }
+}
+
+
+/**
+ * Rebuilds the connection lines if the selected Node changed.
+ * The lines are red for positive and blue for negative weights,
+ * their alpha grows with the weight's magnitude.
+ * 
+ * \param mlp Pointer to the MLP.
+ * \param layout Pointer to the Layout of the MLP.
+ * \param layer The selected Node's layer. Must be greater than zero.
+ * \param node The selected Node's index inside the layer.
+ */
+static void update_lines(MLP *mlp, const Layout *layout, size_t layer, size_t node)
+{
+    if(lines.vertices.arr != NULL && lines.layer == (long long) layer && lines.node == node)
+        return;
+
+    Vector *prev = &get_vector_as_type(&mlp->layers, layer-1, Vector);
+
+    free_vector(&lines.vertices);
+    lines.vertices = create_vector(prev->size, sizeof(LineVertex), false);
+    lines.layer = layer;
+    lines.node = node;
+
+    double m = 0;
+    for(size_t j = 0; j < prev->size; j++)
+        m = max(m, fabs(get_vector_as_type(&get_vector_as_type(prev, j, Node).con, node, double)));
+
+    for(size_t j = 0; j < prev->size; j++)
+    {
+        double w = get_vector_as_type(&get_vector_as_type(prev, j, Node).con, node, double);
+        Color c = w >= 0 ? RED : BLUE;
+        c.a = m > 0 ? 32 + 223*fabs(w)/m : 255;
+
+        LineVertex v = {layout_node(layout, layer-1, j), c};
+        push_vector(&lines.vertices, &v);
+    }
+}
+
+
+/**
+ * Draws the cached connection lines of the selected Node in a single batch.
+ * Only the lines crossing the camera's view are submitted.
+ * 
+ * \param layout Pointer to the Layout of the MLP.
+ * \param target The selected Node's position.
+ * \param view The area of the 2D plane visible by the camera.
+ */
+static void draw_lines(const Layout *layout, Vector2 target, Rectangle view)
+{
+    size_t first, last;
+    if(!layout_visible_lines(layout, lines.layer-1, target, view, &first, &last))
+        return;
+
+    const LineVertex *v = (const LineVertex*) lines.vertices.arr;
+
+    rlBegin(RL_LINES);
+    for(size_t j = first; j < last; j++)
+    {
+        rlColor4ub(v[j].color.r, v[j].color.g, v[j].color.b, v[j].color.a);
+        rlVertex2f(v[j].pos.x, v[j].pos.y);
+        rlVertex2f(target.x, target.y);
+    }
+    rlEnd();
+}
+
+
+/**
+ * Draws the Nodes of a layer on-screen.
+ * Only the Nodes inside the camera's view are iterated.
+ * The level of detail depends on the zoom: circles when close enough,
+ * and a single activation strip when zoomed out the most.
+ * 
+ * \param layout Pointer to the Layout of the MLP.
+ * \param layer Pointer to the layer to draw.
+ * \param index The layer's index inside the MLP.
+ * \param view The area of the 2D plane visible by the camera.
+ * \param zoom The camera's zoom.
+ */
+static void draw_layer(const Layout *layout, Vector *layer, size_t index, Rectangle view, float zoom)
+{
+    size_t first, last;
+    if(!layout_visible_nodes(layout, index, view, &first, &last))
+        return;
+
+    if(zoom < LOD_CIRCLES)
+    {
+        Texture2D strip = get_vector_as_type(&strips, index, Texture2D);
+        Vector2 top = layout_node(layout, index, 0);
+        DrawTexturePro(strip, (Rectangle) {0, 0, 1, layer->size},
+            (Rectangle) {top.x - NODE_RADIUS, top.y - NODE_SPACING/2.0, 2*NODE_RADIUS, layer->size*NODE_SPACING},
+            (Vector2) {0, 0}, 0, WHITE);
+        return;
+    }
+
+    for(size_t j = first; j < last; j++)
+    {
+        Vector2 circle = layout_node(layout, index, j);
+        DrawCircle(circle.x, circle.y, NODE_RADIUS, BLUE);
+    }
+}
+
+
+/**
+ * Draws the weights of a layer's connections to a target Node as labels on the layer's Nodes.
+ * Only the Nodes inside the camera's view are iterated, and nothing is drawn below the labels' zoom level.
+ * 
+ * \param layout Pointer to the Layout of the MLP.
+ * \param layer Pointer to the layer whose weights should be drawn.
+ * \param index The layer's index inside the MLP.
+ * \param target_index The target Node's index inside the next layer.
+ * \param view The area of the 2D plane visible by the camera.
+ * \param zoom The camera's zoom.
+ */
+static void draw_weights(const Layout *layout, Vector *layer, size_t index, size_t target_index, Rectangle view, float zoom)
+{
+    size_t first, last;
+    if(zoom < LOD_LABELS || !layout_visible_nodes(layout, index, view, &first, &last))
+        return;
+
+    for(size_t j = first; j < last; j++)
+    {
+        Vector2 circle = layout_node(layout, index, j);
+        Node *node = &get_vector_as_type(layer, j, Node);
+        double weight = get_vector_as_type(&node->con, target_index, double);
+
+        Label label = get_label("%.4lf", weight, 10, 2);
+
+        Vector2 box = {circle.x - label.size.x/2.0, circle.y - label.size.y/2.0};
+        DrawRectangle(box.x-4, box.y-2, label.size.x+8, label.size.y+3, DARKBLUE);
+        DrawTextEx(GetFontDefault(), label.text, box, 10, 2, RAYWHITE);
     }
 }
 
@@ -494,12 +856,170 @@ static void draw_output(Vector *layer, double offset, Vector2 center)
     for(long long i = 0; i < layer->size; i++)
     {
         Node *node = &get_vector_as_type(layer, i, Node);
-        const char *str = TextFormat("%llu: %.2lf%%", i, node->output*100);
-        Vector2 strsize = MeasureTextEx(GetFontDefault(), str, 30, 3);
+        // the index labels are few and never change, so they aren't worth a place in the label cache
+        const char *index = TextFormat("%lld: ", i);
+        Vector2 index_size = MeasureTextEx(GetFontDefault(), index, 30, 3);
+        Label perc = get_label("%.2lf%%", node->output*100, 30, 3);
+
+        Vector2 circle = {center.x + offset + 100, center.y + (i-layer->size/2.0)*100 - index_size.y/2.0};
+        DrawTextEx(GetFontDefault(), index, circle, 30, 3, BLACK);
+        DrawTextEx(GetFontDefault(), perc.text, (Vector2) {circle.x + index_size.x + 3, circle.y}, 30, 3, BLACK);
+    }
+}
+
+
+/**
+ * Draws the parts of the network that only depend on the model and the camera:
+ * the layers' trapezoids and edges, the Nodes and the output panel.
+ * 
+ * \param mlp Pointer to the MLP.
+ * \param center A center point for calculating coordinates on the 2D plane.
+ * \param view The area of the 2D plane visible by the camera.
+ * \param zoom The camera's zoom.
+ */
+static void draw_backdrop(MLP *mlp, Vector2 center, Rectangle view, float zoom)
+{
+    static const Color filler = {230, 230, 230, 255};
+
+    // Center point
+    DrawCircle(center.x, center.y, 5, RED);
+
+    Vector *prev = &get_vector_as_type(&mlp->layers, 0, Vector);
+    for(size_t i = 1; i < mlp->layers.size; i++)
+    {
+        Vector *layer = &get_vector_as_type(&mlp->layers, i, Vector);
+        double prevx = layout_layer_x(&layout, i-1);
+        double x = layout_layer_x(&layout, i);
+        
+        Vector2 poly[] = {
+            (Vector2) {prevx, center.y - (prev->size/2.0)*NODE_SPACING},
+            (Vector2) {prevx, center.y + (prev->size-1-prev->size/2.0)*NODE_SPACING},
+            (Vector2) {x, center.y + (layer->size-1-layer->size/2.0)*NODE_SPACING},
+            (Vector2) {x, center.y - (layer->size/2.0)*NODE_SPACING}
+        };
+
+        DrawTriangleFan(poly, 4, filler);
+        DrawLineEx(poly[0], poly[3], 5, BLUE);
+        DrawLineEx(poly[1], poly[2], 5, BLUE);
+
+        draw_layer(&layout, prev, i-1, view, zoom);
+
+        prev = layer;
+    }
+
+    size_t last = mlp->layers.size-1;
+    draw_output(prev, layout_layer_x(&layout, last) - center.x, center);
+    draw_layer(&layout, prev, last, view, zoom);
+}
+
+
+/**
+ * Renders the backdrop into a texture if the camera, the model's outputs or the screen changed since the last time.
+ * 
+ * \param mlp Pointer to the MLP.
+ * \param camera The current camera.
+ * \param center A center point for calculating coordinates on the 2D plane.
+ * \param view The area of the 2D plane visible by the camera.
+ */
+static void update_backdrop(MLP *mlp, Camera2D camera, Vector2 center, Rectangle view)
+{
+    bool resized = backdrop.id == 0 || backdrop.texture.width != GetScreenWidth() || backdrop.texture.height != GetScreenHeight();
+    bool moved = !Vector2Equals(camera.target, backdrop_camera.target) || !Vector2Equals(camera.offset, backdrop_camera.offset)
+        || camera.zoom != backdrop_camera.zoom || camera.rotation != backdrop_camera.rotation;
+
+    if(!backdrop_stale && !resized && !moved && backdrop_runs == mlp->runs)
+        return;
+
+    if(resized)
+    {
+        if(backdrop.id != 0)
+            UnloadRenderTexture(backdrop);
+        backdrop = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+    }
+
+    BeginTextureMode(backdrop);
+    ClearBackground(WHITE);
+    BeginMode2D(camera);
+    draw_backdrop(mlp, center, view, camera.zoom);
+    EndMode2D();
+    EndTextureMode();
+
+    backdrop_camera = camera;
+    backdrop_runs = mlp->runs;
+    backdrop_stale = false;
+}
+
+
+/**
+ * Draws the receptive field atlas centered on a point of the 2D plane.
+ * The texture is uploaded the first time the atlas is shown.
+ * 
+ * \param center The point to center the atlas on.
+ */
+static void draw_heatmap(Vector2 center)
+{
+    if(heatmap_texture.id == 0)
+    {
+        heatmap_texture = LoadTextureFromImage(heatmap.image);
+        SetTextureFilter(heatmap_texture, TEXTURE_FILTER_POINT);
+    }
+
+    float w = heatmap_texture.width * HEATMAP_SCALE;
+    float h = heatmap_texture.height * HEATMAP_SCALE;
+    DrawTexturePro(heatmap_texture, (Rectangle) {0, 0, heatmap_texture.width, heatmap_texture.height},
+        (Rectangle) {center.x - w/2, center.y - h/2, w, h}, (Vector2) {0, 0}, 0, WHITE);
+}
+
+
+/**
+ * Draws the network and handles hovering and selecting its Nodes.
+ * 
+ * \param mlp Pointer to the MLP.
+ * \param camera Pointer to the current camera.
+ * \param center A center point for calculating coordinates on the 2D plane.
+ * \param mouse The cursor's current position on the 2D plane.
+ * \param sel_layer Pointer to the selected Node's layer, -1 if nothing is selected.
+ * \param sel_node Pointer to the selected Node's index inside its layer.
+ */
+static void draw_network(MLP *mlp, Camera2D *camera, Vector2 center, Vector2 mouse, long long *sel_layer, size_t *sel_node)
+{
+    Rectangle view = camera_view(*camera);
+
+    if(camera->zoom < LOD_CIRCLES)
+        update_strips(mlp);
 
-        Vector2 circle = {center.x + offset + 100, center.y + (i-layer->size/2.0)*100 - strsize.y/2.0};
-        DrawTextEx(GetFontDefault(), str, circle, 30, 3, BLACK);
+    // the static parts are only re-rendered when the camera moves
+    update_backdrop(mlp, *camera, center, view);
+    DrawTextureRec(backdrop.texture, (Rectangle) {0, 0, backdrop.texture.width, -backdrop.texture.height}, (Vector2) {0, 0}, WHITE);
+
+    BeginMode2D(*camera);
+
+    if(*sel_layer > 0)
+    {
+        Vector *prev = &get_vector_as_type(&mlp->layers, *sel_layer-1, Vector);
+        Vector2 target = layout_node(&layout, *sel_layer, *sel_node);
+
+        update_lines(mlp, &layout, *sel_layer, *sel_node);
+        draw_lines(&layout, target, view);
+        draw_weights(&layout, prev, *sel_layer-1, *sel_node, view, camera->zoom);
     }
+
+    size_t hit_layer, hit_node;
+    if(layout_hit(&layout, mouse, &hit_layer, &hit_node))
+    {
+        Vector *layer = &get_vector_as_type(&mlp->layers, hit_layer, Vector);
+        draw_node_info(get_vector_as_type(layer, hit_node, Node), *camera);
+
+        // only Nodes with incoming connections can be selected
+        if(hit_layer > 0 && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        {
+            bool same = *sel_layer == (long long) hit_layer && *sel_node == hit_node;
+            *sel_layer = same ? -1 : (long long) hit_layer;
+            *sel_node = hit_node;
+        }
+    }
+
+    EndMode2D();
 }
 
 
@@ -508,16 +1028,28 @@ GUISTATE show_simulation_gui(MLP *mlp, Camera2D *camera)
     static Vector2 screen_center = {-1, -1};
     static Vector2 center = {-1, -1};
 
-    static Vector2 click = {-1, -1};
+    static long long sel_layer = -1;
+    static size_t sel_node = 0;
+
+    static bool fields = false;
 
-    static Color filler = (Color) {230, 230, 230, 255};
-    
     if(Vector2Equals(center, (Vector2) {-1, -1}))
     {
         screen_center = (Vector2) {GetScreenWidth()/2.0, GetScreenHeight()/2.0};
         center = GetScreenToWorld2D(screen_center, *camera);
     }
 
+    if(layout_stale)
+    {
+        free_layout(&layout);
+        layout = create_layout(mlp, center);
+        layout_stale = false;
+        backdrop_stale = true;
+        unload_strips();
+        free_vector(&lines.vertices);
+        sel_layer = -1;
+    }
+
     /**
      * Camera movement and zoom code is from:
      * https://github.com/raysan5/raylib/blob/master/examples/core/core_2d_camera_mouse_zoom.c
@@ -553,59 +1085,19 @@ GUISTATE show_simulation_gui(MLP *mlp, Camera2D *camera)
 
     Vector2 mouse = GetScreenToWorld2D(GetMousePosition(), *camera);
 
-    BeginMode2D(*camera);
-
-    // Center point
-    DrawCircle(center.x, center.y, 5, RED);
-    double prevoffset = 0;
-
-    Vector *first = &get_vector_as_type(&mlp->layers, 0, Vector);
-    Vector *prev = first;
-    for(long long i = 1; i < mlp->layers.size; i++)
+    if(fields)
     {
-        Vector *layer = &get_vector_as_type(&mlp->layers, i, Vector);
-        double offset = prevoffset + sqrt(exp(log2(prev->size)))*100;
-        
-        Vector2 poly[] = {
-            (Vector2) {center.x + prevoffset, center.y - (prev->size/2.0)*100},
-            (Vector2) {center.x + prevoffset, center.y + (prev->size-1-prev->size/2.0)*100},
-            (Vector2) {center.x + offset, center.y + (layer->size-1-layer->size/2.0)*100},
-            (Vector2) {center.x + offset, center.y - (layer->size/2.0)*100}
-        };
-
-        DrawTriangleFan(poly, 4, filler);
-        DrawLineEx(poly[0], poly[3], 5, BLUE);
-        DrawLineEx(poly[1], poly[2], 5, BLUE);
-        
-        size_t target_node = 0;
-
-        for(long long j = 0; j < layer->size; j++)
-        {
-            Vector2 circle = (Vector2) {center.x + offset, center.y + (j-layer->size/2.0)*100};
-
-            if(CheckCollisionPointCircle(mouse, circle, 30))    
-            {
-                draw_node_info(get_vector_as_type(layer, j, Node), *camera);
-
-                if(IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
-                    click = Vector2Equals(click, circle) ? (Vector2) {-1, -1} : circle;
-            }
-
-            if(Vector2Equals(click, circle))
-                target_node = (size_t) j;
-        }
-
-        
-        draw_layer(prev, ((int)click.x == (int)(center.x+offset)) ? &click : NULL, target_node, center, prevoffset, camera, mouse);
-
-        prev = layer;
-        prevoffset = offset;
+        BeginMode2D(*camera);
+        draw_heatmap(center);
+        EndMode2D();
+    }
+    else
+    {
+        draw_network(mlp, camera, center, mouse, &sel_layer, &sel_node);
     }
 
-    draw_output(prev, prevoffset, center);
-    draw_layer(prev, NULL, 0, center, prevoffset, camera, mouse);
-
-    EndMode2D();
+    if(GuiButton((Rectangle) {GetScreenWidth()-100, GetScreenHeight()-150, 90, 40}, fields ? "Network" : "Fields"))
+        fields = !fields;
 
     if(GuiButton((Rectangle) {GetScreenWidth()-100, GetScreenHeight()-100, 90, 40}, "Save result"))
         write_model_result(mlp, DISK);
@@ -616,6 +1108,7 @@ GUISTATE show_simulation_gui(MLP *mlp, Camera2D *camera)
     return IsKeyPressed(KEY_ESCAPE) ? DRAWING : SIMULATION;
 }
 
+
 void free_loaded_mlp_vector(Vector *paths, Vector *names)
 {
     for(int i = 0; i < names->size; i++)
@@ -635,3 +1128,42 @@ void free_file_dialog()
     if(dialog_ready)
         FreeDialog(&file_dialog);
 }
+
+
+void free_draw_gui()
+{
+    free_brush_stamps();
+
+    if(overlay.id != 0)
+        UnloadTexture(overlay);
+    overlay = (Texture2D) {0};
+
+
+    if(board.id != 0)
+        UnloadTexture(board);
+    board = (Texture2D) {0};
+
+    free(board_pixels);
+    board_pixels = NULL;
+    board_stale = true;
+}
+
+
+void free_simulation_gui()
+{
+    free_heatmap(&heatmap);
+    if(heatmap_texture.id != 0)
+        UnloadTexture(heatmap_texture);
+    heatmap_texture = (Texture2D) {0};
+
+    if(backdrop.id != 0)
+        UnloadRenderTexture(backdrop);
+    backdrop = (RenderTexture2D) {0};
+    backdrop_stale = true;
+
+    free_vector(&lines.vertices);
+
+    unload_strips();
+    free_layout(&layout);
+    layout_stale = true;
+}
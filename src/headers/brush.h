@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "mlp.h"
+#include "raylib.h"
+
+
+typedef enum TOOL {
+    BRUSH,
+    PENCIL
+} TOOL;
+
+
+/**
+ * Returns the stamp of the brush for a given radius, computing it on the first request.
+ * A stamp is a (2*radius-1)x(2*radius-1) array of brush intensities between 0 and 1 in column-major order,
+ * with negative values where the cell is outside the brush.
+ * 
+ * \param radius The radius of the brush.
+ * 
+ * \returns Pointer to the stamp's first element. Stays valid until free_brush_stamps() is called.
+ */
+const double* get_brush_stamp(int radius);
+
+
+/**
+ * Draws the brush at a given position on an MLP's drawing Canvas with a given radius.
+ * The intensities are looked up from a stamp that is computed once per radius.
+ * 
+ * \param mlp Pointer to the MLP that contains the two Canvases used by this function.
+ * \param pos The brush's position on the Canvas.
+ * \param tool BRUSH or PENCIL
+ * \param eraser Is the eraser enabled?
+ * \param radius The radius of the brush.
+ */
+void draw_brush(MLP *mlp, Vector2 *pos, TOOL tool, bool eraser, int radius);
+
+
+/**
+ * Draws the brush along a segment, stamping it at every cell between the two endpoints.
+ * This keeps fast strokes continuous, even if the cursor skipped cells between two frames.
+ * 
+ * \param mlp Pointer to the MLP that contains the two Canvases used by this function.
+ * \param from The segment's starting position on the Canvas.
+ * \param to The segment's ending position on the Canvas.
+ * \param tool BRUSH or PENCIL
+ * \param eraser Is the eraser enabled?
+ * \param radius The radius of the brush.
+ */
+void draw_stroke(MLP *mlp, Vector2 *from, Vector2 *to, TOOL tool, bool eraser, int radius);
+
+
+/**
+ * Finishes a stroke: the drawing Canvas becomes the base Canvas the next stroke is drawn over.
+ * 
+ * \param mlp Pointer to the MLP that contains the two Canvases.
+ */
+void end_stroke(MLP *mlp);
+
+
+/**
+ * Frees the cached brush stamps.
+ */
+void free_brush_stamps();
@@ -66,3 +66,12 @@ void set_canvas_xy(Canvas *canvas, size_t x, size_t y, double n);
  * \param Canvas Pointer to the target Canvas.
  */
 void clear_canvas(Canvas *canvas);
+
+
+/**
+ * Converts a Canvas into 8-bit pixels, rounding each value.
+ * 
+ * \param Canvas Pointer to the source Canvas. Its values should be between 0 and 255.
+ * \param out Array of width*height elements, receives the pixels in row-major order.
+ */
+void canvas_pixels(const Canvas *canvas, unsigned char *out);
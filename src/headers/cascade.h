@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mlp.h"
+#include "idx.h"
+#include "eval.h"
+
+/** The default minimal probability of the cheap model's answer. */
+#define CASCADE_MIN_PROB 0.9
+
+
+/**
+ * Thresholds of a cascade, where a cheap model answers first
+ * and an expensive model is only run when the cheap one isn't confident enough.
+ */
+typedef struct Cascade {
+    /** The cheap model's answer is only accepted if its probability is at least this. */
+    double min_prob;
+    /** The cheap model's answer is only accepted if it leads the second most probable class by at least this much probability. */
+    double min_margin;
+} Cascade;
+
+
+/** Thresholds that no answer can meet, so every image is escalated to the expensive model. */
+#define CASCADE_ALWAYS_ESCALATE ((Cascade) {2, 0})
+
+
+/** The outputs of both models of a cascade on every image of a dataset. */
+typedef struct CascadeScores {
+    size_t count;
+    /** Size of the output layer of the models. */
+    size_t classes;
+    /** The label of each image, or the number of classes if the label isn't an output of the models. */
+    size_t *labels;
+    /** The winner, its probability and its lead over the second class by the cheap model for each image. */
+    size_t *cheap_results;
+    double *cheap_probs, *cheap_margins;
+    /** The winner of the expensive model for each image. */
+    size_t *expensive_results;
+    /** The time it took to pool and run each model on each image, in seconds. */
+    double *cheap_times, *expensive_times;
+} CascadeScores;
+
+
+/**
+ * Checks if a cascade accepts the cheap model's answer.
+ * 
+ * \param c The thresholds of the cascade.
+ * \param prob The cheap model's output probabilities.
+ * \param size Number of outputs.
+ * \param result Pointer that receives the index of the most probable output.
+ * 
+ * \returns True if the answer is confident enough, false if the expensive model should be run.
+ */
+bool cascade_accepts(Cascade c, const double *prob, size_t size, size_t *result);
+
+
+/**
+ * Runs both models of a cascade on every image of a dataset, spread between the threads of the thread pool.
+ * Every threshold can be evaluated from the returned scores without running the models again.
+ * The returned CascadeScores should be freed by the caller,
+ * as it contains dynamically allocated memory.
+ * 
+ * \param cheap Pointer to the cheap MLP.
+ * \param expensive Pointer to the expensive MLP, with as many outputs as the cheap one.
+ * \param images Pointer to the images.
+ * \param labels Pointer to the labels.
+ * 
+ * \returns The scores of the two models.
+ */
+CascadeScores score_cascade(const MLP *cheap, const MLP *expensive, const IdxFile *images, const IdxFile *labels);
+
+
+/**
+ * Evaluates a cascade on scored images.
+ * The returned Evaluation should be freed by the caller.
+ * 
+ * \param scores Pointer to the scores.
+ * \param c The thresholds of the cascade.
+ * \param escalated Pointer that receives the number of images the expensive model was needed for.
+ * \param latency Pointer that receives the average time the cascade needs for an image, in seconds.
+ * 
+ * \returns The Evaluation of the cascade.
+ */
+Evaluation evaluate_cascade(const CascadeScores *scores, Cascade c, size_t *escalated, double *latency);
+
+
+/**
+ * Writes the accuracy, the escalation rate and the average latency of a range of thresholds,
+ * and suggests the one escalating the fewest images while staying close to the expensive model's accuracy.
+ * 
+ * \param f The stream to write to.
+ * \param scores Pointer to the scores.
+ * \param best Pointer that receives the suggested thresholds, only written if there is a suggestion.
+ * 
+ * \returns True if any of the thresholds stayed close enough to the expensive model's accuracy.
+ */
+bool tune_cascade(FILE *f, const CascadeScores *scores, Cascade *best);
+
+
+/**
+ * Frees all the dynamically allocated memory used by the scores.
+ * 
+ * \param scores Pointer to the CascadeScores.
+ */
+void free_cascade_scores(CascadeScores *scores);
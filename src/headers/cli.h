@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+
+
+/**
+ * Checks if the program was started in a headless mode.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns True if run_cli() should be called instead of opening a window.
+ */
+bool is_cli(int argc, char *argv[]);
+
+
+/**
+ * Runs the program without a window, based on its command line arguments.
+ * 
+ * --infer model.mlpmodel|models.ensemble [--input path]... [--format csv|json] [--output path] [--top k] [--invert]
+ *         [--cascade expensive.mlpmodel [--min-prob p] [--min-margin m]]
+ * 
+ * Classifies every input with the model. An input can be an image file, or a text file
+ * with one drawing per line as x*y whitespace separated values between 0 and 255, in row-major order.
+ * The path "-" or the lack of inputs means the standard input in the text format.
+ * The predictions are written as CSV or JSON, the throughput and the latency percentiles to the standard error.
+ * With a cascade, the expensive model answers instead whenever the model's answer isn't confident enough.
+ * 
+ * --eval model.mlpmodel|models.ensemble --images images-idx3-ubyte --labels labels-idx1-ubyte [--threads n]
+ *        [--cascade expensive.mlpmodel [--min-prob p] [--min-margin m] [--tune]]
+ * 
+ * Evaluates the model on a labelled IDX dataset like MNIST, using every processor unless the number of threads is given.
+ * The accuracy, the precision and recall of each class and the confusion matrix are written to the standard output.
+ * With a cascade, the escalation rate and the average latency are written too, and --tune chooses the thresholds if any of them are accurate enough.
+ * 
+ * Both modes also accept an ensemble definition (.ensemble) instead of a model, see read_ensemble(), but not in a cascade.
+ * 
+ * --serve and --loadgen start the inference server and its load generator, see run_server() and run_loadgen().
+ * --replay replays a recorded drawing session, see run_replay().
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns The program's exit code.
+ */
+int run_cli(int argc, char *argv[]);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "vector.h"
+#include "mlp.h"
+
+
+/** The latest result of a compared model. */
+typedef struct CompareResult {
+    /** Name of the model. */
+    const char *name;
+    /** Index of the winning output. */
+    size_t result;
+    /** Probability of the winning output. */
+    double prob;
+    /** Time it took to resample, pool and run the drawing, in seconds. */
+    double latency;
+} CompareResult;
+
+
+/**
+ * Loads every model of a list to compare them on the same drawings.
+ * Nothing is reloaded if the list hasn't changed since the last call.
+ * The models are run by a background thread on the thread pool, or on that thread alone if the pool isn't running.
+ * 
+ * \param paths Pointer to the Vector of the models' paths as 'char*' values.
+ * \param names Pointer to the Vector of the models' names as 'char*' values.
+ */
+void set_compared_models(const Vector *paths, const Vector *names);
+
+
+/**
+ * Takes a snapshot of an MLP's drawing Canvas and hands it to the compared models without blocking.
+ * Each model resamples the drawing to its own Canvas and kernel size.
+ * If the models are still busy, the snapshot replaces any older request that wasn't started yet.
+ * 
+ * \param mlp Pointer to the MLP whose drawing is compared.
+ */
+void request_comparison(const MLP *mlp);
+
+
+/**
+ * Queries the number of compared models.
+ * 
+ * \returns The number of models that could be loaded.
+ */
+size_t compared_model_count();
+
+
+/**
+ * Queries the latest results of the compared models.
+ * 
+ * \param out Array with at least compared_model_count() elements, receives the results in the order of the list.
+ * 
+ * \returns The number of finished comparisons, zero if there wasn't any yet.
+ */
+size_t get_comparison(CompareResult *out);
+
+
+/**
+ * Checks if a requested comparison hasn't finished yet.
+ * 
+ * \returns True if a comparison is waiting or running.
+ */
+bool comparison_busy();
+
+
+/**
+ * Stops the background thread and frees the compared models. The thread pool is left running for its other users.
+ */
+void stop_comparison();
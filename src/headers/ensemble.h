@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "mlp.h"
+#include "idx.h"
+#include "eval.h"
+#include "forward.h"
+#include "filehandler.h"
+
+
+/** The ways the members' outputs can be combined. */
+typedef enum ENSEMBLEMODE {
+    AVERAGE,    /*!< The weighted average of the members' probabilities. */
+    VOTE        /*!< The weighted share of the members voting for each class. */
+} ENSEMBLEMODE;
+
+
+/** A model of an ensemble. */
+typedef struct Member {
+    MLP mlp;
+    double weight;
+    InferContext ctx;
+    /** Index of the pooled input the member runs on, shared by the members with the same Canvas and kernel size. */
+    size_t input;
+} Member;
+
+
+/**
+ * Several models that classify the same inputs together.
+ * The members are run concurrently on the thread pool.
+ */
+typedef struct Ensemble {
+    ENSEMBLEMODE mode;
+    Member *members;
+    size_t count;
+    /** Number of outputs, the same for every member. */
+    size_t classes;
+    /** The distinct pooled inputs of the members, each as large as the input layer of the first member using it. */
+    double **inputs;
+    size_t input_count;
+    /** The probabilities of each member after the last run, 'classes' values per member. */
+    double *outputs;
+    /** The combined probabilities after the last run. */
+    double *prob;
+    /** Index of the most probable class after the last run. */
+    size_t result;
+} Ensemble;
+
+
+/** Contains a status code and an Ensemble if the reading was successful. */
+typedef struct EnsembleRead {
+    /** The status code of the reading. Can be either SUCCESS or an error code of the definition or of a member. */
+    RSTATUS status;
+    /** The line of the definition where the error was found, zero if the error isn't tied to a line. */
+    size_t line;
+    /** The returned Ensemble if the reading was successful. Empty otherwise. */
+    Ensemble ensemble;
+} EnsembleRead;
+
+
+/**
+ * Reads an ensemble definition and every member model listed in it.
+ * 
+ * Each line of the definition is either "mode average" or "mode vote",
+ * or the path of a member model followed by its weight. Relative paths start from the definition's directory.
+ * Empty lines and lines starting with '#' are ignored. The members must have the same number of outputs,
+ * otherwise the status is OUTPUTMISMATCH. Without any members it's NOMODEL.
+ * The returned Ensemble should be freed by the caller,
+ * as it contains dynamically allocated memory.
+ * 
+ * \param path Path to the definition.
+ * 
+ * \returns The status of the reading and the Ensemble.
+ */
+EnsembleRead read_ensemble(const char *path);
+
+
+/**
+ * Runs every member on an 8-bit grayscale image and combines their outputs.
+ * The image is resampled and pooled once for each distinct Canvas and kernel size.
+ * 
+ * \param e Pointer to the Ensemble.
+ * \param pixels The image's pixels in row-major order.
+ * \param width Width of the image.
+ * \param height Height of the image.
+ * 
+ * \returns The index of the most probable class.
+ */
+size_t run_ensemble(Ensemble *e, const unsigned char *pixels, size_t width, size_t height);
+
+
+/**
+ * Finds the member with the largest Canvas. Inputs should be staged at its size,
+ * so no member gets a lower resolution image than its own Canvas.
+ * 
+ * \param e Pointer to the Ensemble.
+ * 
+ * \returns Pointer to the first member with the most Canvas cells.
+ */
+Member* largest_member(Ensemble *e);
+
+
+/**
+ * Finds the most probable classes after the last run, like mlp_topk().
+ * 
+ * \param e Pointer to the Ensemble.
+ * \param k Number of classes to find.
+ * \param out_idx Array of k elements, receives the indices of the classes in descending order of probability.
+ * \param out_prob Array of k elements, receives the combined probabilities of the classes. Can be NULL.
+ * 
+ * \returns The number of found classes, the smaller of k and the number of classes.
+ */
+size_t ensemble_topk(const Ensemble *e, size_t k, size_t *out_idx, double *out_prob);
+
+
+/**
+ * Runs an Ensemble on every image of a dataset.
+ * The returned Evaluation should be freed by the caller.
+ * 
+ * \param e Pointer to the Ensemble.
+ * \param images Pointer to the images.
+ * \param labels Pointer to the labels.
+ * 
+ * \returns The Evaluation of the Ensemble.
+ */
+Evaluation evaluate_ensemble(Ensemble *e, const IdxFile *images, const IdxFile *labels);
+
+
+/**
+ * Frees all the dynamically allocated memory used by the Ensemble and its members.
+ * 
+ * \param e Pointer to the Ensemble.
+ */
+void free_ensemble(Ensemble *e);
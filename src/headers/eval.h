@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "mlp.h"
+#include "idx.h"
+
+
+/** The results of running a model on a labelled dataset. */
+typedef struct Evaluation {
+    /** Size of the model's output layer. */
+    size_t classes;
+    /** Number of evaluated images. */
+    size_t total;
+    /** Number of correctly classified images. */
+    size_t correct;
+    /** Number of images whose label isn't an output of the model. These aren't evaluated. */
+    size_t skipped;
+    /** The confusion matrix, the number of images with label i classified as j is at [i*classes + j]. */
+    size_t *confusion;
+} Evaluation;
+
+
+/**
+ * Runs an MLP on every image of a dataset, spread between the threads of the thread pool.
+ * The images are pooled straight from the IDX file and the MLP isn't modified.
+ * The returned Evaluation should be freed by the caller,
+ * as it contains dynamically allocated memory.
+ * 
+ * \param mlp Pointer to the MLP.
+ * \param images Pointer to the images.
+ * \param labels Pointer to the labels, with the same number of items as the images.
+ * 
+ * \returns The Evaluation of the MLP.
+ */
+Evaluation evaluate_mlp(const MLP *mlp, const IdxFile *images, const IdxFile *labels);
+
+
+/**
+ * Writes the accuracy, the precision and recall of each class and the confusion matrix.
+ * 
+ * \param f The stream to write to.
+ * \param eval Pointer to the Evaluation.
+ */
+void print_evaluation(FILE *f, const Evaluation *eval);
+
+
+/**
+ * Frees all the dynamically allocated memory used by the Evaluation.
+ * 
+ * \param eval Pointer to the Evaluation.
+ */
+void free_evaluation(Evaluation *eval);
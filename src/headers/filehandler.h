@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdio.h>
+
 #include "mlp.h"
 
 
@@ -10,7 +12,9 @@ typedef enum RSTATUS {
     NODATA,             /*!< Couldn't read the requested data from a file or EOF is reached. */
     KERNELSIZE,         /*!< The kernel size is invalid for the MaxPool2D operation. */
     NOLAYER,            /*!< There isn't enough layers in the MLP. */
-    WRONGINSTRUCTION    /*!< The given instruction doesn't exist. */
+    WRONGINSTRUCTION,   /*!< The given instruction doesn't exist. */
+    NOMODEL,            /*!< An ensemble doesn't list any models. */
+    OUTPUTMISMATCH      /*!< The models of an ensemble have different numbers of outputs. */
 } RSTATUS;
 
 
@@ -46,6 +50,7 @@ ReadResult read_model(const char *path, const char *name);
 
 /**
  * Writes the current output probabilities of an MLP either into a file, to the standard output or both.
+ * This is only a formatting layer on top of mlp_topk(), inference doesn't need to call it.
  * 
  * \param mlp Pointer to the target MLP.
  * \param mode Specifies where the function should write the MLP's output.
@@ -53,3 +58,14 @@ ReadResult read_model(const char *path, const char *name);
  * \returns True if the writing was successful.
  */
 bool write_model_result(MLP *mlp, WRITEMODE mode);
+
+
+/**
+ * Prints output probabilities and a result to a stream in the format used by write_model_result().
+ * 
+ * \param f The stream to print to.
+ * \param prob Array of the output probabilities.
+ * \param size The number of probabilities.
+ * \param result The index of the winning output.
+ */
+void print_result(FILE *f, const double *prob, size_t size, size_t result);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "mlp.h"
+
+
+/**
+ * Scratch space for running an MLP without modifying it.
+ * Any number of contexts can run the same MLP at the same time, as long as the MLP isn't changed meanwhile.
+ */
+typedef struct InferContext {
+    const MLP *mlp;
+    /** Size of the largest layer. */
+    size_t width;
+    /** The largest number of inputs that can be run at once. */
+    size_t capacity;
+    /** Outputs of the current and the next layer of each input during a run, 'width' values per input. */
+    double *a, *b;
+    /**
+     * The output layer's outputs after the last run, points into one of the buffers.
+     * The outputs of the n-th input start at [n*width].
+     */
+    const double *output;
+    /** Size of the output layer. */
+    size_t outputs;
+} InferContext;
+
+
+/**
+ * Creates the scratch space for running an MLP.
+ * The returned InferContext should be freed by the caller,
+ * as it contains dynamically allocated memory.
+ * 
+ * \param mlp Pointer to the MLP. It must stay valid while the context is used.
+ * 
+ * \returns The newly created InferContext.
+ */
+InferContext create_infer_context(const MLP *mlp);
+
+
+/**
+ * Creates the scratch space for running an MLP on several inputs at once.
+ * The returned InferContext should be freed by the caller,
+ * as it contains dynamically allocated memory.
+ * 
+ * \param mlp Pointer to the MLP. It must stay valid while the context is used.
+ * \param capacity The largest number of inputs of a single run.
+ * 
+ * \returns The newly created InferContext.
+ */
+InferContext create_batch_context(const MLP *mlp, size_t capacity);
+
+
+/**
+ * Frees all the dynamically allocated memory used by the context.
+ * 
+ * \param ctx Pointer to the InferContext.
+ */
+void free_infer_context(InferContext *ctx);
+
+
+/**
+ * Runs the context's MLP on a pooled input in a feed-forward manner, without touching the MLP's Nodes.
+ * The outputs are the same as the ones of run_mlp() before softmax is applied.
+ * 
+ * \param ctx Pointer to the InferContext.
+ * \param in Array with as many elements as the input layer.
+ * 
+ * \returns The index of the first output with the largest value.
+ */
+size_t infer_mlp(InferContext *ctx, const double *in);
+
+
+/**
+ * Runs the context's MLP on several pooled inputs in a single feed-forward pass.
+ * Each weight is loaded once for the whole batch instead of once per input.
+ * 
+ * \param ctx Pointer to the InferContext.
+ * \param in The inputs one after another, each with as many elements as the input layer.
+ * \param n Number of inputs, at most the context's capacity.
+ * \param results Array of n elements, receives the index of the largest output of each input.
+ */
+void infer_mlp_batch(InferContext *ctx, const double *in, size_t n, size_t *results);
+
+
+/**
+ * Calculates the softmax probabilities of the outputs of the last run.
+ * If the last run was a batch, these are the probabilities of its first input.
+ * 
+ * \param ctx Pointer to the InferContext.
+ * \param out Array with as many elements as the output layer, receives the probabilities.
+ */
+void infer_probabilities(const InferContext *ctx, double *out);
+
+
+/**
+ * Calculates the softmax probabilities of the outputs of an input of the last batch.
+ * 
+ * \param ctx Pointer to the InferContext.
+ * \param n Index of the input in the batch.
+ * \param out Array with as many elements as the output layer, receives the probabilities.
+ */
+void infer_batch_probabilities(const InferContext *ctx, size_t n, double *out);
@@ -60,3 +60,15 @@ void free_loaded_mlp_vector(Vector *paths, Vector *names);
  * Frees the memory allocated by the file dialog.
  */
 void free_file_dialog();
+
+
+/**
+ * Frees the memory and textures allocated by the "draw GUI".
+ */
+void free_draw_gui();
+
+
+/**
+ * Frees the memory allocated by the "simulation GUI".
+ */
+void free_simulation_gui();
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "mlp.h"
+#include "raylib.h"
+
+
+/**
+ * An atlas of the first hidden layer's receptive fields.
+ * Each cell shows the incoming weights of a single Node as an (x/kx)x(y/ky) image,
+ * normalized by the largest weight magnitude of that Node.
+ */
+typedef struct Heatmap {
+    /** The atlas in RGBA format. Positive weights are red, negative ones are blue. */
+    Image image;
+    /** Number of cells in a row and in a column. */
+    size_t cols, rows;
+    /** Size of a single cell in pixels, without the 1 pixel gap between the cells. */
+    size_t cell_w, cell_h;
+} Heatmap;
+
+
+/**
+ * Builds the receptive field atlas of an MLP.
+ * The returned Heatmap should be freed by the caller,
+ * as it contains dynamically allocated memory.
+ * 
+ * \param mlp Pointer to the MLP. It must have at least two layers.
+ * 
+ * \returns The new Heatmap struct.
+ */
+Heatmap create_heatmap(const MLP *mlp);
+
+
+/**
+ * Frees all dynamically allocated memory used by a Heatmap.
+ * 
+ * \param heatmap Pointer to the Heatmap.
+ */
+void free_heatmap(Heatmap *heatmap);
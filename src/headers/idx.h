@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/**
+ * An IDX file of unsigned bytes, like the images and labels of the MNIST dataset.
+ * The file is mapped into memory instead of being read, so the items are only loaded when they are used.
+ */
+typedef struct IdxFile {
+    /** Number of items, the size of the first dimension. */
+    size_t count;
+    /** Size of the second and the third dimension, one if the file has fewer dimensions. */
+    size_t rows, cols;
+    /** The items one after another, each of them rows*cols bytes. */
+    const unsigned char *items;
+    /** The whole mapped file. */
+    unsigned char *file;
+    size_t file_size;
+} IdxFile;
+
+
+/**
+ * Opens an IDX file with one, two or three dimensions of unsigned bytes.
+ * The returned IdxFile should be closed by the caller.
+ * 
+ * \param path Path to the file.
+ * \param idx Pointer to the IdxFile to fill.
+ * 
+ * \returns True if the file could be opened and is a valid IDX file.
+ */
+bool open_idx(const char *path, IdxFile *idx);
+
+
+/**
+ * Queries an item of an IDX file.
+ * 
+ * \param idx Pointer to the IdxFile.
+ * \param i The index of the item.
+ * 
+ * \returns Pointer to the first byte of the item.
+ */
+const unsigned char* get_idx_item(const IdxFile *idx, size_t i);
+
+
+/**
+ * Unmaps an IDX file.
+ * 
+ * \param idx Pointer to the IdxFile.
+ */
+void close_idx(IdxFile *idx);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mlp.h"
+
+
+/** The latest result finished by the inference worker. */
+typedef struct InferenceResult {
+    /** Index of the winning output Node. */
+    size_t result;
+    /** Probability of the winning output Node. */
+    double prob;
+    /** Number of finished inferences, zero if there wasn't any yet. */
+    size_t seq;
+} InferenceResult;
+
+
+/**
+ * Starts a background thread that runs an MLP on the requested inputs.
+ * While the worker is running, only the worker may touch the MLP's layers.
+ * The Canvases still belong to the caller.
+ * 
+ * \param mlp Pointer to the MLP to run. It must stay valid until the worker is stopped.
+ * 
+ * \returns True if the worker is running.
+ */
+bool start_inference_worker(MLP *mlp);
+
+
+/**
+ * Takes a snapshot of the pooled Canvas of the worker's MLP and hands it to the worker without blocking on the inference.
+ * If the worker is still busy, the snapshot replaces any older request that wasn't started yet.
+ */
+void request_inference();
+
+
+/**
+ * Queries the latest result finished by the worker.
+ * 
+ * \returns The latest result. Its seq is zero if no inference was finished yet.
+ */
+InferenceResult get_inference_result();
+
+
+/**
+ * Checks if the worker has a request that is waiting or being computed.
+ * 
+ * \returns True if a new result is still to come.
+ */
+bool inference_busy();
+
+
+/**
+ * Blocks until the worker has finished every request.
+ * Afterwards the MLP's layers can be read safely until the next request.
+ */
+void sync_inference_worker();
+
+
+/**
+ * Stops the worker thread and frees its buffers.
+ * Unstarted requests are dropped.
+ */
+void stop_inference_worker();
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "raylib.h"
+
+/** Number of labels the cache can hold. Must be a power of two. */
+#define LABEL_CACHE_SIZE 4096
+/** Maximum length of a cached label, including the terminating zero. */
+#define LABEL_LENGTH 32
+
+
+/** A formatted and measured label. */
+typedef struct Label {
+    char text[LABEL_LENGTH];
+    /** The size of the text drawn with the default font. */
+    Vector2 size;
+} Label;
+
+
+/**
+ * Formats and measures a label, or returns it from the cache if it was requested before.
+ * The cache is keyed by the format, the value and the font's parameters.
+ * 
+ * \param format A printf() format string with a single 'double' conversion. Compared by address.
+ * \param value The value to format.
+ * \param font_size The font size used for the measurement.
+ * \param spacing The spacing used for the measurement.
+ * 
+ * \returns A copy of the cached Label.
+ */
+Label get_label(const char *format, double value, float font_size, float spacing);
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "vector.h"
+#include "mlp.h"
+#include "raylib.h"
+
+/** Vertical distance between two neighbouring Nodes of a layer. */
+#define NODE_SPACING 100
+/** Radius of a Node's circle. */
+#define NODE_RADIUS 30
+
+
+/**
+ * Positions of an MLP's Nodes on the 2D plane of the explore view.
+ * Computed once per model, with a uniform grid for hit-testing.
+ */
+typedef struct Layout {
+    /** The point the layout is centered on. */
+    Vector2 center;
+    /** X coordinate of each layer as 'double' values. */
+    Vector xs;
+    /** Number of Nodes in each layer as 'size_t' values. */
+    Vector sizes;
+    /**
+     * Uniform grid of NODE_SPACING wide cells along the X axis, starting at 'origin'.
+     * Each cell holds the indices of at most two layers whose circles reach into it, or -1 in unused slots.
+     * Along the Y axis the cells line up with the Nodes, so they don't have to be stored.
+     */
+    Vector grid;
+    double origin;
+} Layout;
+
+
+/**
+ * Computes the layout of an MLP.
+ * The returned Layout should be freed by the caller,
+ * as it contains dynamically allocated memory.
+ * 
+ * \param mlp Pointer to the MLP.
+ * \param center The point to center the layout on.
+ * 
+ * \returns The new Layout struct.
+ */
+Layout create_layout(const MLP *mlp, Vector2 center);
+
+
+/**
+ * Frees all dynamically allocated memory used by a Layout.
+ * 
+ * \param layout Pointer to the Layout.
+ */
+void free_layout(Layout *layout);
+
+
+/**
+ * Queries the X coordinate of a layer.
+ * 
+ * \param layout Pointer to the Layout.
+ * \param layer The layer's index.
+ * 
+ * \returns The X coordinate shared by every Node of the layer.
+ */
+double layout_layer_x(const Layout *layout, size_t layer);
+
+
+/**
+ * Queries the position of a Node.
+ * 
+ * \param layout Pointer to the Layout.
+ * \param layer The layer's index.
+ * \param node The Node's index inside the layer.
+ * 
+ * \returns The center of the Node's circle.
+ */
+Vector2 layout_node(const Layout *layout, size_t layer, size_t node);
+
+
+/**
+ * Finds the Node whose circle contains a given point.
+ * Only a few candidates are checked, thanks to the grid.
+ * 
+ * \param layout Pointer to the Layout.
+ * \param pos The point on the 2D plane.
+ * \param layer Receives the layer's index if a Node was found.
+ * \param node Receives the Node's index if a Node was found.
+ * 
+ * \returns True if a Node was found.
+ */
+bool layout_hit(const Layout *layout, Vector2 pos, size_t *layer, size_t *node);
+
+
+/**
+ * Computes which Nodes of a layer reach into a rectangle, without iterating over the layer.
+ * 
+ * \param layout Pointer to the Layout.
+ * \param layer The layer's index.
+ * \param view The visible rectangle on the 2D plane.
+ * \param first Receives the index of the first visible Node.
+ * \param last Receives the index after the last visible Node.
+ * 
+ * \returns True if at least one Node is visible.
+ */
+bool layout_visible_nodes(const Layout *layout, size_t layer, Rectangle view, size_t *first, size_t *last);
+
+
+/**
+ * Computes which Nodes of a layer have a connection line to a target point that crosses a rectangle.
+ * The lines start at the Nodes' centers and end at the target, which should be to the right of the layer.
+ * 
+ * \param layout Pointer to the Layout.
+ * \param layer The layer's index.
+ * \param target The end point of the lines.
+ * \param view The visible rectangle on the 2D plane.
+ * \param first Receives the index of the first Node with a visible line.
+ * \param last Receives the index after the last Node with a visible line.
+ * 
+ * \returns True if at least one line is visible.
+ */
+bool layout_visible_lines(const Layout *layout, size_t layer, Vector2 target, Rectangle view, size_t *first, size_t *last);
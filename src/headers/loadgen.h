@@ -0,0 +1,18 @@
+#pragma once
+
+
+/**
+ * Sends requests to a running inference server from concurrent clients and measures the latencies, based on its command line arguments.
+ * Not available on Windows.
+ * 
+ * --loadgen [--socket path] [--port n] [--model name] [--clients n] [--requests n] [--size n]
+ * 
+ * Every client sends its requests one after another, waiting for each response.
+ * The images are random strokes of the given size. The throughput and the latency percentiles are written to the standard output.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns The program's exit code.
+ */
+int run_loadgen(int argc, char *argv[]);
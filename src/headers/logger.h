@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mlp.h"
+
+/** Number of results the logger can hold before new ones are dropped. Must be a power of two. */
+#define LOG_CAPACITY 64
+/** Maximum number of output probabilities stored for a single result. */
+#define LOG_MAX_CLASSES 32
+
+
+/**
+ * Starts the background thread that writes the logged results.
+ * 
+ * \param path Path to the file the results should be appended to. The standard output is used if NULL.
+ * \param interval The minimum time between two written results in seconds.
+ * Results logged in the meantime are coalesced, only the newest one is written.
+ * 
+ * \returns True if the logger is running.
+ */
+bool start_result_logger(const char *path, double interval);
+
+
+/**
+ * Queues the current output of an MLP for logging without blocking.
+ * The result is dropped if the queue is full or the logger isn't running.
+ * Should only be called from one thread at a time.
+ * 
+ * \param mlp Pointer to the MLP whose result should be logged.
+ * 
+ * \returns True if the result was queued.
+ */
+bool log_model_result(MLP *mlp);
+
+
+/**
+ * Writes the last pending result and stops the background thread of the logger.
+ */
+void stop_result_logger();
@@ -17,9 +17,16 @@ typedef struct MLP {
     size_t x, y, kx, ky;
     char *name;
     Vector layers;
+    /** The drawing as it was before the current stroke. */
     Canvas canvas;
+    /** The current drawing, this is what the model's input is pooled from. */
     Canvas draw_canvas;
+    /** Index of the output Node with the highest output after the last run. */
     size_t result;
+    /** True if the output layer holds softmax probabilities, false if it still holds the raw outputs. */
+    bool probabilities;
+    /** Number of times the model was run. Can be used to detect new outputs. */
+    size_t runs;
 } MLP;
 
 
@@ -100,6 +107,37 @@ void set_node_bias(MLP *mlp, size_t layer, size_t n, double bias);
 void free_mlp(MLP *mlp);
 
 
+/**
+ * Applies the MaxPooling to an MLP's Canvas without touching the input layer.
+ * 
+ * \param mlp Pointer to the target MLP.
+ * \param out Array with as many elements as the input layer, receives the pooled values.
+ */
+void pool_mlp_input(const MLP *mlp, double *out);
+
+
+/**
+ * Applies the MaxPooling to an 8-bit grayscale image instead of the MLP's Canvas.
+ * The image is resampled to the Canvas' size with nearest-neighbour sampling, so no copy is made if the sizes match.
+ * 
+ * \param mlp Pointer to the target MLP.
+ * \param pixels The image's pixels in row-major order.
+ * \param width Width of the image.
+ * \param height Height of the image.
+ * \param out Array with as many elements as the input layer, receives the pooled values.
+ */
+void pool_pixels(const MLP *mlp, const unsigned char *pixels, size_t width, size_t height, double *out);
+
+
+/**
+ * Sets the values of an MLP's input layer.
+ * 
+ * \param mlp Pointer to the target MLP.
+ * \param in Array with as many elements as the input layer.
+ */
+void set_mlp_input(MLP *mlp, const double *in);
+
+
 /**
  * Loads the contents of an MLP's Canvas to the input layer.
  * The MaxPooling is also done by this step.
@@ -112,7 +150,68 @@ void load_mlp_input(MLP *mlp);
 /**
  * Runs the MLP model in a simple feed-forward manner,
  * calculating the output for the current input layer.
+ * The output layer will contain probabilities and the MLP's result will be updated.
  * 
  * \param mlp Pointer to the target MLP.
  */
 void run_mlp(MLP *mlp);
+
+
+/**
+ * Runs the MLP model like run_mlp(), but only finds the winning output Node.
+ * The output layer keeps its raw outputs until mlp_probabilities() is called.
+ * 
+ * \param mlp Pointer to the target MLP.
+ * 
+ * \returns The index of the output Node with the highest output.
+ */
+size_t run_mlp_argmax(MLP *mlp);
+
+
+/**
+ * Finds the largest values of an array, without any I/O.
+ * Equal values keep their order, so the first of them comes first.
+ * 
+ * \param values The values.
+ * \param size Number of values.
+ * \param k The maximum number of results.
+ * \param out_idx Array of at least k elements that receives the indices in descending order of value.
+ * \param out_values Array of at least k elements that receives the values. Can be NULL.
+ * 
+ * \returns The number of results written, which is k or size if it is smaller.
+ */
+size_t topk(const double *values, size_t size, size_t k, size_t *out_idx, double *out_values);
+
+
+/**
+ * Converts raw outputs into probabilities with softmax, without any I/O.
+ * The maximum output is subtracted before exponentiation, so large outputs can't overflow.
+ * 
+ * \param values The raw outputs.
+ * \param size Number of outputs.
+ * \param out Array of at least size elements that receives the probabilities. Can be the same as values.
+ */
+void softmax(const double *values, size_t size, double *out);
+
+
+/**
+ * Finds the output Nodes with the highest outputs after the last run, without any I/O.
+ * The raw outputs are enough for the ordering, softmax is only applied if probabilities are requested.
+ * 
+ * \param mlp Pointer to the target MLP.
+ * \param k The maximum number of results.
+ * \param out_idx Array of at least k elements that receives the indices in descending order of output.
+ * \param out_prob Array of at least k elements that receives the probabilities. Can be NULL.
+ * 
+ * \returns The number of results written, which is k or the size of the output layer if it is smaller.
+ */
+size_t mlp_topk(MLP *mlp, size_t k, size_t *out_idx, double *out_prob);
+
+
+/**
+ * Converts the output layer's raw outputs into probabilities with softmax.
+ * Does nothing if the outputs are already probabilities.
+ * 
+ * \param mlp Pointer to the target MLP.
+ */
+void mlp_probabilities(MLP *mlp);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mlp.h"
+#include "brush.h"
+#include "vector.h"
+
+
+/** The kinds of recorded drawing events. */
+typedef enum STROKEEVENT {
+    CANVAS,     /*!< The drawing board's size, recorded when a model with a new size is drawn on. */
+    STROKE,     /*!< A segment of the brush, a single stamp if its endpoints are the same. */
+    RELEASE,    /*!< The end of a stroke, the drawing becomes the base of the next stroke. */
+    CLEAR       /*!< Both Canvases are cleared, by the Clear button or by loading a model. */
+} STROKEEVENT;
+
+
+/** A single recorded drawing event. */
+typedef struct StrokeEvent {
+    /** Seconds since the recording started. */
+    double time;
+    STROKEEVENT type;
+    TOOL tool;
+    bool eraser;
+    int radius;
+    /** The segment of a STROKE, or the size of the CANVAS in 'to'. */
+    Vector2 from, to;
+} StrokeEvent;
+
+
+/**
+ * Starts recording the drawing events into a file, one event per line.
+ * 
+ * \param path Path to the file. It's overwritten.
+ * 
+ * \returns True if the file could be opened.
+ */
+bool start_recording(const char *path);
+
+
+/**
+ * Records a stroke segment drawn on an MLP's Canvas. Does nothing if there is no recording.
+ * The size of the MLP's Canvas is also recorded if it's different from the last one.
+ * 
+ * \param mlp Pointer to the MLP that was drawn on.
+ * \param from The segment's starting position on the Canvas.
+ * \param to The segment's ending position on the Canvas.
+ * \param tool BRUSH or PENCIL
+ * \param eraser Is the eraser enabled?
+ * \param radius The radius of the brush.
+ */
+void record_stroke(const MLP *mlp, Vector2 from, Vector2 to, TOOL tool, bool eraser, int radius);
+
+
+/**
+ * Records an event without a position (RELEASE or CLEAR). Does nothing if there is no recording.
+ * 
+ * \param type The type of the event.
+ */
+void record_event(STROKEEVENT type);
+
+
+/**
+ * Finishes the recording and closes its file.
+ */
+void stop_recording();
+
+
+/**
+ * Reads a recording.
+ * 
+ * \param path Path to the recording.
+ * \param events Pointer to the Vector receiving the StrokeEvent values. Should be created by the caller.
+ * 
+ * \returns True if every line of the recording is a valid event.
+ */
+bool read_recording(const char *path, Vector *events);
+
+
+/**
+ * Applies an event to an MLP's Canvases the way the drawing board does.
+ * 
+ * \param mlp Pointer to the MLP.
+ * \param e Pointer to the event.
+ * 
+ * \returns True if the drawing Canvas may have changed, so the model's result is outdated.
+ */
+bool apply_stroke_event(MLP *mlp, const StrokeEvent *e);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "mlp.h"
+
+
+/**
+ * A model held by the registry. The MLP is only read once it's registered,
+ * so any number of users can run it at the same time.
+ */
+typedef struct ModelEntry {
+    MLP mlp;
+    /** Path of the model file, used for reloading. */
+    char *path;
+    /** Modification time of the file when it was read, in nanoseconds where the platform has them. */
+    long long mtime;
+    /** Size of the file when it was read. */
+    long long size;
+    /** Number of holders: the registry while the entry is current, and every user that acquired it. */
+    size_t refs;
+    /** True if a newer version replaced the entry, so it's only kept alive by its users. */
+    bool retired;
+} ModelEntry;
+
+
+/**
+ * Reads a model and adds it to the registry under the model's name, which is its file name without the extension.
+ * A model already registered with the same name is replaced and retired.
+ * Like every function of the registry, this must be called from a single thread.
+ * 
+ * \param path Path to the model file.
+ * 
+ * \returns True if the model could be read.
+ */
+bool register_model(const char *path);
+
+
+/**
+ * Queries the current entry of a model and keeps it alive until it's released.
+ * 
+ * \param name Name of the model, NULL or an empty string for the first registered model.
+ * 
+ * \returns Pointer to the entry, NULL if there is no such model.
+ */
+ModelEntry* acquire_model(const char *name);
+
+
+/**
+ * Gives up a reference to an entry. The entry is freed when it's retired and nobody uses it anymore.
+ * 
+ * \param entry Pointer to the entry.
+ */
+void release_model(ModelEntry *entry);
+
+
+/**
+ * Reads every registered model again whose file has changed since it was read, and swaps in the new version.
+ * The old versions are retired, and stay valid while they are acquired.
+ * 
+ * \returns The number of swapped models.
+ */
+size_t reload_models();
+
+
+/**
+ * Queries the number of registered models.
+ * 
+ * \returns The number of current entries.
+ */
+size_t registered_model_count();
+
+
+/**
+ * Queries a registered model by its index, in the order of registration.
+ * The entry isn't acquired.
+ * 
+ * \param i The index.
+ * 
+ * \returns Pointer to the current entry.
+ */
+ModelEntry* get_registered_model(size_t i);
+
+
+/**
+ * Retires and releases every registered model.
+ * Acquired entries stay valid until they are released.
+ */
+void free_registry();
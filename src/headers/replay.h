@@ -0,0 +1,20 @@
+#pragma once
+
+
+/**
+ * Replays a recorded drawing session on a model without a window, based on its command line arguments.
+ * 
+ * --replay strokes.txt --model model.mlpmodel [--realtime] [--max-p99 us]
+ * 
+ * Every event is applied to the model's Canvases like on the drawing board. After each event that changes the drawing,
+ * the input is pooled and the model is run, and the time from the event to the result is measured.
+ * The result at the end of each stroke is written to the standard output, the latency percentiles to the standard error.
+ * With --realtime the events are replayed at their recorded times, otherwise as fast as possible.
+ * With --max-p99 the exit code is 1 if the 99th percentile of the latency is above the limit.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns The program's exit code.
+ */
+int run_replay(int argc, char *argv[]);
@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * The protocol of the inference server.
+ * 
+ * A request is the length of the model's name in a byte and the name itself, an empty name meaning the first served model.
+ * These are followed by the width and the height of an image as 16-bit big-endian integers,
+ * and the image's 8-bit grayscale pixels in row-major order.
+ * The image is resampled to the model's Canvas, so it doesn't have to match its size.
+ * 
+ * The response is the index of the winning class and its probability in millionths,
+ * both as 32-bit big-endian integers. Responses are sent in the order of the requests.
+ * A request for an unknown model gets RESPONSE_ERROR as its class, a malformed request closes the connection.
+ */
+
+/** The default path of the server's UNIX domain socket. */
+#define SERVER_SOCKET "/tmp/nagyhazi.sock"
+/** Size of a request's header in bytes, without the model's name. */
+#define REQUEST_HEADER 5
+/** The largest width and height of a requested image. */
+#define REQUEST_MAX_SIDE 1024
+/** Size of a response in bytes. */
+#define RESPONSE_SIZE 8
+/** The class of the response to a request that couldn't be run. */
+#define RESPONSE_ERROR 0xFFFFFFFF
+
+
+/**
+ * Runs the inference server until it's interrupted, based on its command line arguments.
+ * Not available on Windows.
+ * 
+ * --serve model.mlpmodel [--serve model.mlpmodel]... [--socket path] [--port n] [--batch n] [--deadline ms] [--threads n]
+ * 
+ * Serves every given model, routing the requests by the models' names, which are their file names without the extension.
+ * On SIGHUP the models whose files have changed are read again and swapped in, after the requests already waiting for the old versions are answered.
+ * Listens on a UNIX domain socket, and on the given localhost TCP port if there is one.
+ * The requests of each model are collected into a batch until it's full, its oldest request has waited for the deadline,
+ * or every client has a request in a batch, then the whole batch is run in a single forward pass.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns The program's exit code.
+ */
+int run_server(int argc, char *argv[]);
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
 
 /**
  * Macro that compares two values and returns the greater one.
@@ -42,6 +45,18 @@
 char* strclone(const char *str);
 
 
+/**
+ * Parses a positive decimal number of a command line argument.
+ * Unlike strtoul(), signs, whitespace, trailing characters, zero and overflowing values are rejected.
+ * 
+ * \param str The string to parse.
+ * \param out Pointer to store the number in, only written if the string is valid.
+ * 
+ * \returns True if the string was a positive number.
+ */
+bool parse_size(const char *str, size_t *out);
+
+
 /**
  * Calls memdump() with the current file's name
  * and the line number where the macro was used.
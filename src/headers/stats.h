@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "vector.h"
+
+
+/** Descriptive statistics of a set of samples. */
+typedef struct Summary {
+    size_t count;
+    double mean, stddev;
+    double min, median, p95, p99, max;
+} Summary;
+
+
+/**
+ * Returns the time elapsed since an unspecified starting point.
+ * Only the difference of two calls is meaningful.
+ * 
+ * \returns The time in seconds.
+ */
+double now_seconds();
+
+
+/**
+ * Calculates the statistics of a Vector of 'double' samples.
+ * The samples are sorted in place.
+ * 
+ * \param samples Pointer to the Vector of samples.
+ * 
+ * \returns The Summary of the samples. Every field is zero if there are no samples.
+ */
+Summary summarize(Vector *samples);
+
+
+/**
+ * Queries a percentile of sorted samples with the nearest-rank method.
+ * 
+ * \param sorted Array of samples in ascending order.
+ * \param n Number of samples. Must be greater than zero.
+ * \param p The percentile between 0 and 100.
+ * 
+ * \returns The sample at the given percentile.
+ */
+double percentile(const double *sorted, size_t n, double p);
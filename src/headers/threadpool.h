@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/** Larger thread counts are capped at this many threads per processor, as they'd only add overhead. */
+#define MAX_THREADS_PER_PROCESSOR 4
+
+
+/**
+ * A task of a parallel run, called once for every index.
+ * 
+ * \param arg The argument given to run_parallel().
+ * \param index The index of the call.
+ */
+typedef void (*ParallelTask)(void *arg, size_t index);
+
+
+/**
+ * Queries the number of processors that are available to the program.
+ * 
+ * \returns The number of online processors, at least one.
+ */
+size_t processor_count();
+
+
+/**
+ * Starts the worker threads of the thread pool.
+ * The workers only allocate memory through their tasks, so tasks shouldn't use malloc() while debugmalloc is active.
+ * 
+ * \param count Number of threads that run the tasks including the caller, zero to use every processor.
+ *              Capped at MAX_THREADS_PER_PROCESSOR threads per processor.
+ * 
+ * \returns True if the pool is running.
+ */
+bool start_thread_pool(size_t count);
+
+
+/**
+ * Queries how many threads run the tasks of run_parallel(), including the caller.
+ * 
+ * \returns The number of threads, one if the pool isn't running.
+ */
+size_t thread_pool_size();
+
+
+/**
+ * Calls a task for every index between zero and count, spread between the pool's threads and the caller.
+ * Blocks until every call is finished. Must be called from a single thread at a time.
+ * If the pool isn't running, every call is made on the calling thread.
+ * 
+ * \param task The task to run.
+ * \param arg The argument passed to every call.
+ * \param count Number of calls.
+ */
+void run_parallel(ParallelTask task, void *arg, size_t count);
+
+
+/**
+ * Stops and joins the worker threads of the thread pool.
+ */
+void stop_thread_pool();
@@ -0,0 +1,68 @@
+#include "debugmalloc.h"
+#include "heatmap.h"
+#include <math.h>
+
+#include "snippets.h"
+
+
+Heatmap create_heatmap(const MLP *mlp)
+{
+    Vector *input = &get_vector_as_type(&mlp->layers, 0, Vector);
+    Vector *hidden = &get_vector_as_type(&mlp->layers, 1, Vector);
+    const Node *sources = (const Node*) input->arr;
+    size_t n = hidden->size;
+
+    Heatmap h;
+    h.cell_w = mlp->x/mlp->kx;
+    h.cell_h = mlp->y/mlp->ky;
+    h.cols = ceil(sqrt(n));
+    h.rows = h.cols == 0 ? 0 : (n + h.cols - 1)/h.cols;
+
+    // the atlas can be larger than what debugmalloc allows, so raylib allocates it
+    int width = h.cols*(h.cell_w+1) + 1;
+    int height = h.rows*(h.cell_h+1) + 1;
+    h.image = GenImageColor(width, height, LIGHTGRAY);
+
+    // each source Node stores its weights to every hidden Node contiguously,
+    // so both passes go through the sources and vectorize over the hidden Nodes
+    double scale[n];
+    for(size_t j = 0; j < n; j++)
+        scale[j] = 0;
+
+    for(size_t k = 0; k < input->size; k++)
+    {
+        const double *w = (const double*) sources[k].con.arr;
+        for(size_t j = 0; j < n; j++)
+            scale[j] = fmax(scale[j], fabs(w[j]));
+    }
+
+    for(size_t j = 0; j < n; j++)
+        scale[j] = scale[j] > 0 ? 1/scale[j] : 0;
+
+    Color *pixels = (Color*) h.image.data;
+    for(size_t k = 0; k < input->size; k++)
+    {
+        const double *w = (const double*) sources[k].con.arr;
+        size_t px = k % h.cell_w;
+        size_t py = k / h.cell_w;
+
+        for(size_t j = 0; j < n; j++)
+        {
+            double t = w[j]*scale[j];
+            unsigned char fade = 255*(1 - fabs(t));
+            size_t x = (j % h.cols)*(h.cell_w+1) + 1 + px;
+            size_t y = (j / h.cols)*(h.cell_h+1) + 1 + py;
+
+            pixels[y*width + x] = t >= 0 ? (Color) {255, fade, fade, 255} : (Color) {fade, fade, 255, 255};
+        }
+    }
+
+    return h;
+}
+
+
+void free_heatmap(Heatmap *heatmap)
+{
+    UnloadImage(heatmap->image);
+    heatmap->image = (Image) {0};
+}
@@ -0,0 +1,132 @@
+#include "debugmalloc.h"
+#include "idx.h"
+#include <stdint.h>
+#ifdef _WIN32
+#include "raylib.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/** Type code of unsigned bytes in the magic number. */
+#define IDX_UBYTE 0x08
+
+
+/**
+ * Maps a whole file into memory for reading.
+ * 
+ * \param path Path to the file.
+ * \param size Pointer that receives the size of the file.
+ * 
+ * \returns Pointer to the contents, NULL if the file couldn't be mapped.
+ */
+static unsigned char* map_file(const char *path, size_t *size)
+{
+#ifdef _WIN32
+    int n = 0;
+    unsigned char *data = LoadFileData(path, &n);
+    *size = n;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+        return NULL;
+
+    // the items are read once from the beginning to the end
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    *size = st.st_size;
+    return (unsigned char*) data;
+#endif
+}
+
+
+/**
+ * Unmaps a file mapped by map_file().
+ * 
+ * \param data Pointer to the contents.
+ * \param size Size of the file.
+ */
+static void unmap_file(unsigned char *data, size_t size)
+{
+#ifdef _WIN32
+    UnloadFileData(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+
+/**
+ * Reads a big-endian 32-bit unsigned integer.
+ * 
+ * \param p Pointer to the first byte.
+ * 
+ * \returns The integer.
+ */
+static uint32_t read_be32(const unsigned char *p)
+{
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+
+bool open_idx(const char *path, IdxFile *idx)
+{
+    *idx = (IdxFile) {0, 1, 1, NULL, NULL, 0};
+
+    size_t size = 0;
+    unsigned char *file = map_file(path, &size);
+    if(file == NULL)
+        return false;
+
+    // two zero bytes, the type code and the number of dimensions, then a 32-bit size for each dimension
+    size_t dims = size >= 4 ? file[3] : 0;
+    if(size < 4 + 4*dims || file[0] != 0 || file[1] != 0 || file[2] != IDX_UBYTE || dims < 1 || dims > 3)
+    {
+        unmap_file(file, size);
+        return false;
+    }
+
+    size_t shape[3] = {1, 1, 1};
+    for(size_t i = 0; i < dims; i++)
+        shape[i] = read_be32(file + 4 + 4*i);
+
+    size_t header = 4 + 4*dims;
+    if(shape[1] == 0 || shape[2] == 0 || (size - header) / (shape[1]*shape[2]) < shape[0])
+    {
+        unmap_file(file, size);
+        return false;
+    }
+
+    *idx = (IdxFile) {shape[0], shape[1], shape[2], file + header, file, size};
+    return true;
+}
+
+
+const unsigned char* get_idx_item(const IdxFile *idx, size_t i)
+{
+    return idx->items + i * idx->rows * idx->cols;
+}
+
+
+void close_idx(IdxFile *idx)
+{
+    if(idx->file != NULL)
+        unmap_file(idx->file, idx->file_size);
+
+    *idx = (IdxFile) {0, 1, 1, NULL, NULL, 0};
+}
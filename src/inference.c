@@ -0,0 +1,175 @@
+#include "debugmalloc.h"
+#include "inference.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "errors.h"
+#include "logger.h"
+
+
+static bool running = false;
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t idle = PTHREAD_COND_INITIALIZER;
+
+static MLP *model = NULL;
+static size_t input_size = 0;
+
+/** The mailbox, holding the newest request if pending is true. */
+static double *slot = NULL;
+/** Buffer that the next snapshot is pooled into before it's swapped into the slot. */
+static double *staging = NULL;
+/** Buffer of the request that is currently computed. */
+static double *work = NULL;
+
+static bool pending = false;
+static bool computing = false;
+static bool stopping = false;
+
+static InferenceResult latest = {0, 0, 0};
+
+
+/**
+ * The worker thread's main loop.
+ * Takes the newest request out of the mailbox, runs the model on it and publishes the result.
+ */
+static void* worker_loop(void *arg)
+{
+    pthread_mutex_lock(&lock);
+    while(true)
+    {
+        while(!pending && !stopping)
+            pthread_cond_wait(&wake, &lock);
+
+        if(stopping)
+            break;
+
+        double *t = work;
+        work = slot;
+        slot = t;
+        pending = false;
+        computing = true;
+        pthread_mutex_unlock(&lock);
+
+        set_mlp_input(model, work);
+        run_mlp(model);
+
+        InferenceResult r;
+        mlp_topk(model, 1, &r.result, &r.prob);
+        log_model_result(model);
+
+        pthread_mutex_lock(&lock);
+        r.seq = latest.seq+1;
+        latest = r;
+        computing = false;
+        if(!pending)
+            pthread_cond_broadcast(&idle);
+    }
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
+
+
+bool start_inference_worker(MLP *mlp)
+{
+    if(running)
+        stop_inference_worker();
+
+    model = mlp;
+    input_size = get_vector_as_type(&mlp->layers, 0, Vector).size;
+    slot = malloc(input_size * sizeof(double));
+    staging = malloc(input_size * sizeof(double));
+    work = malloc(input_size * sizeof(double));
+    if(slot == NULL || staging == NULL || work == NULL)
+        exit(ERR_NULLPOINTER);
+
+    pending = false;
+    computing = false;
+    stopping = false;
+    latest = (InferenceResult){mlp->result, 0, 0};
+
+    if(pthread_create(&thread, NULL, worker_loop, NULL) != 0)
+    {
+        free(slot);
+        free(staging);
+        free(work);
+        model = NULL;
+        return false;
+    }
+
+    running = true;
+    return true;
+}
+
+
+void request_inference()
+{
+    if(!running)
+        return;
+
+    pool_mlp_input(model, staging);
+
+    pthread_mutex_lock(&lock);
+    double *t = slot;
+    slot = staging;
+    staging = t;
+    pending = true;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+}
+
+
+InferenceResult get_inference_result()
+{
+    pthread_mutex_lock(&lock);
+    InferenceResult r = latest;
+    pthread_mutex_unlock(&lock);
+
+    return r;
+}
+
+
+bool inference_busy()
+{
+    pthread_mutex_lock(&lock);
+    bool busy = pending || computing;
+    pthread_mutex_unlock(&lock);
+
+    return busy;
+}
+
+
+void sync_inference_worker()
+{
+    if(!running)
+        return;
+
+    pthread_mutex_lock(&lock);
+    while(pending || computing)
+        pthread_cond_wait(&idle, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+
+void stop_inference_worker()
+{
+    if(!running)
+        return;
+
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&lock);
+
+    pthread_join(thread, NULL);
+
+    free(slot);
+    free(staging);
+    free(work);
+    slot = staging = work = NULL;
+    model = NULL;
+    running = false;
+}
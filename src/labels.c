@@ -0,0 +1,64 @@
+#include "debugmalloc.h"
+#include "labels.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/** An entry of the direct-mapped label cache. */
+typedef struct LabelEntry {
+    bool used;
+    const char *format;
+    double value;
+    float font_size, spacing;
+    Label label;
+} LabelEntry;
+
+
+static LabelEntry cache[LABEL_CACHE_SIZE];
+
+
+/**
+ * Hashes the key of a label with FNV-1a.
+ * 
+ * \returns The index of the label's slot in the cache.
+ */
+static size_t hash_label(const char *format, double value, float font_size, float spacing)
+{
+    struct { const char *format; double value; float font_size, spacing; } key;
+    memset(&key, 0, sizeof(key));
+    key.format = format;
+    key.value = value;
+    key.font_size = font_size;
+    key.spacing = spacing;
+
+    const unsigned char *bytes = (const unsigned char*) &key;
+    uint64_t h = 14695981039346656037ULL;
+    for(size_t i = 0; i < sizeof(key); i++)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h & (LABEL_CACHE_SIZE-1);
+}
+
+
+Label get_label(const char *format, double value, float font_size, float spacing)
+{
+    LabelEntry *e = &cache[hash_label(format, value, font_size, spacing)];
+
+    if(e->used && e->format == format && e->value == value && e->font_size == font_size && e->spacing == spacing)
+        return e->label;
+
+    e->used = true;
+    e->format = format;
+    e->value = value;
+    e->font_size = font_size;
+    e->spacing = spacing;
+    snprintf(e->label.text, LABEL_LENGTH, format, value);
+    e->label.size = MeasureTextEx(GetFontDefault(), e->label.text, font_size, spacing);
+
+    return e->label;
+}
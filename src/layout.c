@@ -0,0 +1,187 @@
+#include "debugmalloc.h"
+#include "layout.h"
+#include <math.h>
+
+#include "snippets.h"
+
+
+/** A cell of the Layout's grid. */
+typedef struct GridCell {
+    long long layers[2];
+} GridCell;
+
+
+Layout create_layout(const MLP *mlp, Vector2 center)
+{
+    Layout l;
+    l.center = center;
+    l.xs = create_vector(mlp->layers.size, sizeof(double), false);
+    l.sizes = create_vector(mlp->layers.size, sizeof(size_t), false);
+
+    double x = center.x;
+    for(size_t i = 0; i < mlp->layers.size; i++)
+    {
+        Vector *layer = &get_vector_as_type(&mlp->layers, i, Vector);
+        if(i > 0)
+        {
+            Vector *prev = layer-1;
+            x += sqrt(exp(log2(prev->size)))*NODE_SPACING;
+        }
+
+        push_vector(&l.xs, &x);
+        push_vector(&l.sizes, &layer->size);
+    }
+
+    // the layers are at least NODE_SPACING apart, so a cell can't reach more than two circles
+    l.origin = center.x - NODE_RADIUS;
+    size_t cells = (x + NODE_RADIUS - l.origin)/NODE_SPACING + 1;
+    l.grid = create_vector(cells, sizeof(GridCell), false);
+
+    GridCell empty = {{-1, -1}};
+    for(size_t i = 0; i < cells; i++)
+        push_vector(&l.grid, &empty);
+
+    for(size_t i = 0; i < l.xs.size; i++)
+    {
+        double lx = get_vector_as_type(&l.xs, i, double);
+        size_t first = (lx - NODE_RADIUS - l.origin)/NODE_SPACING;
+        size_t last = (lx + NODE_RADIUS - l.origin)/NODE_SPACING;
+
+        for(size_t c = first; c <= last && c < cells; c++)
+        {
+            GridCell *cell = &get_vector_as_type(&l.grid, c, GridCell);
+            cell->layers[cell->layers[0] == -1 ? 0 : 1] = i;
+        }
+    }
+
+    return l;
+}
+
+
+void free_layout(Layout *layout)
+{
+    free_vector(&layout->xs);
+    free_vector(&layout->sizes);
+    free_vector(&layout->grid);
+}
+
+
+double layout_layer_x(const Layout *layout, size_t layer)
+{
+    return get_vector_as_type(&layout->xs, layer, double);
+}
+
+
+Vector2 layout_node(const Layout *layout, size_t layer, size_t node)
+{
+    size_t size = get_vector_as_type(&layout->sizes, layer, size_t);
+
+    return (Vector2) {layout_layer_x(layout, layer), layout->center.y + (node - size/2.0)*NODE_SPACING};
+}
+
+
+bool layout_hit(const Layout *layout, Vector2 pos, size_t *layer, size_t *node)
+{
+    if(pos.x < layout->origin)
+        return false;
+
+    size_t c = (pos.x - layout->origin)/NODE_SPACING;
+    if(c >= layout->grid.size)
+        return false;
+
+    GridCell *cell = &get_vector_as_type(&layout->grid, c, GridCell);
+    for(int i = 0; i < 2 && cell->layers[i] != -1; i++)
+    {
+        size_t l = cell->layers[i];
+        size_t size = get_vector_as_type(&layout->sizes, l, size_t);
+
+        // the nearest Node is the only one that can contain the point
+        double n = round((pos.y - layout->center.y)/NODE_SPACING + size/2.0);
+        if(n < 0 || n >= size)
+            continue;
+
+        Vector2 circle = layout_node(layout, l, n);
+        if(CheckCollisionPointCircle(pos, circle, NODE_RADIUS))
+        {
+            *layer = l;
+            *node = n;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/**
+ * Converts a range of Y coordinates into a range of Node indices inside a layer.
+ * 
+ * \param layout Pointer to the Layout.
+ * \param layer The layer's index.
+ * \param top The smallest Y coordinate.
+ * \param bottom The largest Y coordinate.
+ * \param first Receives the index of the first Node inside the range.
+ * \param last Receives the index after the last Node inside the range.
+ * 
+ * \returns True if the range contains at least one Node.
+ */
+static bool node_range(const Layout *layout, size_t layer, double top, double bottom, size_t *first, size_t *last)
+{
+    size_t size = get_vector_as_type(&layout->sizes, layer, size_t);
+
+    double f = ceil((top - layout->center.y)/NODE_SPACING + size/2.0);
+    double l = floor((bottom - layout->center.y)/NODE_SPACING + size/2.0) + 1;
+    f = max(f, 0.0);
+    l = min(l, (double) size);
+
+    if(f >= l)
+        return false;
+
+    *first = f;
+    *last = l;
+    return true;
+}
+
+
+bool layout_visible_nodes(const Layout *layout, size_t layer, Rectangle view, size_t *first, size_t *last)
+{
+    double x = layout_layer_x(layout, layer);
+    if(x + NODE_RADIUS < view.x || x - NODE_RADIUS > view.x + view.width)
+        return false;
+
+    return node_range(layout, layer, view.y - NODE_RADIUS, view.y + view.height + NODE_RADIUS, first, last);
+}
+
+
+bool layout_visible_lines(const Layout *layout, size_t layer, Vector2 target, Rectangle view, size_t *first, size_t *last)
+{
+    double x = layout_layer_x(layout, layer);
+    double x1 = max((double) view.x, x);
+    double x2 = min((double) (view.x + view.width), (double) target.x);
+    if(x1 > x2 || target.x <= x)
+        return false;
+
+    // on the part of a line that is inside the view's columns, y = start*(1-u) + target.y*u
+    // this grows with the starting Y coordinate, so the lines crossing the view belong to a range of starting points
+    double top = view.y, bottom = view.y + view.height;
+    double lo = INFINITY, hi = -INFINITY;
+    double us[] = {(x1 - x)/(target.x - x), (x2 - x)/(target.x - x)};
+    for(int i = 0; i < 2; i++)
+    {
+        double w = 1 - us[i];
+        if(w < 1e-9)
+        {
+            if(target.y >= top) lo = -INFINITY;
+            if(target.y <= bottom) hi = INFINITY;
+            continue;
+        }
+
+        lo = min(lo, (top - target.y*us[i])/w);
+        hi = max(hi, (bottom - target.y*us[i])/w);
+    }
+
+    if(lo > hi)
+        return false;
+
+    return node_range(layout, layer, lo, hi, first, last);
+}
@@ -0,0 +1,342 @@
+#include "debugmalloc.h"
+#include "loadgen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int run_loadgen(int argc, char *argv[])
+{
+    fprintf(stderr, "The load generator isn't available on Windows\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "errors.h"
+#include "vector.h"
+#include "server.h"
+#include "stats.h"
+#include "snippets.h"
+
+/** Number of different images the clients cycle through. */
+#define LOADGEN_IMAGES 64
+
+
+/** Settings of the load generator. */
+typedef struct LoadOptions {
+    const char *socket;
+    /** Name of the requested model, an empty string for the server's default model. */
+    const char *model;
+    int port;
+    size_t clients;
+    size_t requests;
+    size_t size;
+} LoadOptions;
+
+
+/** A client thread and its measurements. */
+typedef struct LoadClient {
+    pthread_t thread;
+    size_t index;
+    /** Latency of each request in seconds. */
+    double *latencies;
+    /** Number of requests that got a response. */
+    size_t done;
+    /** Number of responses that reported a class for each class index below 256. */
+    size_t classes[256];
+    /** Number of responses that reported an error. */
+    size_t errors;
+} LoadClient;
+
+
+static LoadOptions opt;
+/** The requests of the clients one after another, each with its header. */
+static unsigned char *requests = NULL;
+static size_t request_size = 0;
+
+
+/**
+ * Connects to the server.
+ * 
+ * \returns The connected socket, -1 if the connection failed.
+ */
+static int connect_server()
+{
+    int fd;
+    if(opt.port > 0)
+    {
+        struct sockaddr_in addr = {0};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(opt.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0)
+        {
+            if(fd >= 0)
+                close(fd);
+            return -1;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    else
+    {
+        struct sockaddr_un addr = {0};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, opt.socket, sizeof(addr.sun_path)-1);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0)
+        {
+            if(fd >= 0)
+                close(fd);
+            return -1;
+        }
+    }
+
+    return fd;
+}
+
+
+/**
+ * Transfers a whole buffer through a socket, retrying short transfers.
+ * 
+ * \param fd The socket.
+ * \param buf The buffer.
+ * \param size Size of the buffer.
+ * \param sending True to send the buffer, false to receive into it.
+ * 
+ * \returns True if the whole buffer was transferred.
+ */
+static bool transfer(int fd, unsigned char *buf, size_t size, bool sending)
+{
+    size_t done = 0;
+    while(done < size)
+    {
+        ssize_t n = sending ? send(fd, buf + done, size - done, MSG_NOSIGNAL) : recv(fd, buf + done, size - done, 0);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        done += n;
+    }
+
+    return true;
+}
+
+
+/**
+ * The main loop of a client thread.
+ * Sends the requests one after another and waits for each response.
+ */
+static void* client_loop(void *arg)
+{
+    LoadClient *client = (LoadClient*) arg;
+
+    int fd = connect_server();
+    if(fd < 0)
+        return NULL;
+
+    for(size_t r = 0; r < opt.requests; r++)
+    {
+        unsigned char *req = requests + ((client->index + r) % LOADGEN_IMAGES) * request_size;
+        unsigned char resp[RESPONSE_SIZE];
+
+        double start = now_seconds();
+        if(!transfer(fd, req, request_size, true) || !transfer(fd, resp, RESPONSE_SIZE, false))
+            break;
+        client->latencies[r] = now_seconds() - start;
+
+        uint32_t result = (uint32_t) resp[0] << 24 | (uint32_t) resp[1] << 16 | (uint32_t) resp[2] << 8 | resp[3];
+        if(result == RESPONSE_ERROR)
+            client->errors++;
+        else if(result < 256)
+            client->classes[result]++;
+        client->done++;
+    }
+
+    close(fd);
+    return NULL;
+}
+
+
+/**
+ * Generates the requests with images of a few random strokes.
+ */
+static void generate_requests()
+{
+    size_t side = opt.size;
+    size_t name_len = strlen(opt.model);
+    request_size = REQUEST_HEADER + name_len + side*side;
+    requests = (unsigned char*) calloc(LOADGEN_IMAGES, request_size);
+    if(requests == NULL)
+        exit(ERR_NULLPOINTER);
+
+    srand(1);
+    for(size_t i = 0; i < LOADGEN_IMAGES; i++)
+    {
+        unsigned char *req = requests + i*request_size;
+        req[0] = name_len;
+        memcpy(req + 1, opt.model, name_len);
+
+        unsigned char *size = req + 1 + name_len;
+        size[0] = side >> 8;
+        size[1] = side;
+        size[2] = side >> 8;
+        size[3] = side;
+
+        unsigned char *px = req + REQUEST_HEADER + name_len;
+        int strokes = 1 + rand() % 3;
+        for(int s = 0; s < strokes; s++)
+        {
+            long x = rand() % side, y = rand() % side;
+            int dx = rand() % 3 - 1, dy = rand() % 3 - 1;
+            for(size_t t = 0; t < side/2; t++)
+            {
+                if(x >= 0 && y >= 0 && x < (long) side && y < (long) side)
+                    px[y*side + x] = 255;
+                x += dx;
+                y += dy;
+            }
+        }
+    }
+}
+
+
+/**
+ * Parses the command line arguments of the load generator.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * 
+ * \returns True if the arguments were valid.
+ */
+static bool parse_load_options(int argc, char *argv[])
+{
+    opt = (LoadOptions) {SERVER_SOCKET, "", 0, 16, 1000, 28};
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i+1 < argc;
+
+        if(strcmp(argv[i], "--loadgen") == 0)
+            continue;
+        else if(strcmp(argv[i], "--socket") == 0 && has_value)
+            opt.socket = argv[++i];
+        else if(strcmp(argv[i], "--model") == 0 && has_value)
+            opt.model = argv[++i];
+        else if(strcmp(argv[i], "--port") == 0 && has_value)
+        {
+            size_t port;
+            if(!parse_size(argv[++i], &port) || port > 65535)
+                return false;
+            opt.port = (int) port;
+        }
+        else if(strcmp(argv[i], "--clients") == 0 && has_value)
+        {
+            if(!parse_size(argv[++i], &opt.clients))
+                return false;
+        }
+        else if(strcmp(argv[i], "--requests") == 0 && has_value)
+        {
+            if(!parse_size(argv[++i], &opt.requests))
+                return false;
+        }
+        else if(strcmp(argv[i], "--size") == 0 && has_value)
+        {
+            if(!parse_size(argv[++i], &opt.size))
+                return false;
+        }
+        else
+            return false;
+    }
+
+    return opt.size <= REQUEST_MAX_SIDE && strlen(opt.model) < 256;
+}
+
+
+int run_loadgen(int argc, char *argv[])
+{
+    if(!parse_load_options(argc, argv))
+    {
+        fprintf(stderr, "Usage: --loadgen [--socket path] [--port n] [--model name] [--clients n] [--requests n] [--size n]\n");
+        return 1;
+    }
+
+    generate_requests();
+
+    // everything is allocated here, the client threads mustn't use debugmalloc
+    LoadClient *clients = (LoadClient*) calloc(opt.clients, sizeof(LoadClient));
+    if(clients == NULL)
+        exit(ERR_NULLPOINTER);
+
+    for(size_t i = 0; i < opt.clients; i++)
+    {
+        clients[i].index = i;
+        clients[i].latencies = (double*) malloc(opt.requests * sizeof(double));
+        if(clients[i].latencies == NULL)
+            exit(ERR_NULLPOINTER);
+    }
+
+    double start = now_seconds();
+    size_t started = 0;
+    for(; started < opt.clients; started++)
+    {
+        if(pthread_create(&clients[started].thread, NULL, client_loop, &clients[started]) != 0)
+            break;
+    }
+    for(size_t i = 0; i < started; i++)
+        pthread_join(clients[i].thread, NULL);
+    double elapsed = now_seconds() - start;
+
+    Vector latencies = create_vector(opt.clients * opt.requests, sizeof(double), false);
+    size_t classes[256] = {0};
+    size_t errors = 0;
+    for(size_t i = 0; i < opt.clients; i++)
+    {
+        errors += clients[i].errors;
+        for(size_t r = 0; r < clients[i].done; r++)
+            push_vector(&latencies, &clients[i].latencies[r]);
+        for(size_t c = 0; c < 256; c++)
+            classes[c] += clients[i].classes[c];
+        free(clients[i].latencies);
+    }
+    free(clients);
+    free(requests);
+
+    Summary s = summarize(&latencies);
+    free_vector(&latencies);
+
+    printf("%zu/%zu requests from %zu clients in %.3lf s, %.1lf requests/s\n",
+        s.count, opt.clients * opt.requests, started, elapsed, elapsed > 0 ? s.count/elapsed : 0);
+    printf("latency (us): mean %.1lf, p50 %.1lf, p95 %.1lf, p99 %.1lf, max %.1lf\n",
+        s.mean*1e6, s.median*1e6, s.p95*1e6, s.p99*1e6, s.max*1e6);
+
+    printf("classes:");
+    for(size_t c = 0; c < 256; c++)
+    {
+        if(classes[c] > 0)
+            printf(" %zu: %zu", c, classes[c]);
+    }
+    printf("\n");
+    if(errors > 0)
+        printf("errors: %zu\n", errors);
+
+    return s.count == opt.clients * opt.requests ? 0 : 1;
+}
+
+#endif
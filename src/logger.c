@@ -0,0 +1,163 @@
+#include "debugmalloc.h"
+#include "logger.h"
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "filehandler.h"
+#include "snippets.h"
+#include "stats.h"
+
+
+/** A single logged result. */
+typedef struct LogEntry {
+    size_t result;
+    size_t size;
+    double prob[LOG_MAX_CLASSES];
+} LogEntry;
+
+
+static LogEntry ring[LOG_CAPACITY];
+static atomic_size_t head = 0;
+static atomic_size_t tail = 0;
+
+static atomic_bool running = false;
+static pthread_t thread;
+static FILE *out = NULL;
+static double min_interval = 0;
+
+
+/**
+ * Checks if two results would be written the same way.
+ * 
+ * \param a Pointer to the first result.
+ * \param b Pointer to the second result.
+ * 
+ * \returns True if the results only differ below the written precision.
+ */
+static bool same_entry(const LogEntry *a, const LogEntry *b)
+{
+    if(a->result != b->result || a->size != b->size)
+        return false;
+
+    for(size_t i = 0; i < a->size; i++)
+    {
+        if(lround(a->prob[i]*10000) != lround(b->prob[i]*10000))
+            return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * The logger thread's main loop.
+ * Drains the queue, keeps only the newest result
+ * and writes it when it differs from the last one and the interval has passed.
+ */
+static void* logger_loop(void *arg)
+{
+    LogEntry latest, written;
+    bool pending = false, any = false;
+    double last = 0;
+
+    while(true)
+    {
+        bool stopping = !atomic_load(&running);
+
+        size_t t = atomic_load_explicit(&tail, memory_order_relaxed);
+        size_t h = atomic_load_explicit(&head, memory_order_acquire);
+        if(t != h)
+        {
+            latest = ring[(h-1) % LOG_CAPACITY];
+            atomic_store_explicit(&tail, h, memory_order_release);
+            pending = !any || !same_entry(&latest, &written);
+        }
+
+        if(pending && (stopping || now_seconds() - last >= min_interval))
+        {
+            print_result(out, latest.prob, latest.size, latest.result);
+            fflush(out);
+
+            written = latest;
+            any = true;
+            pending = false;
+            last = now_seconds();
+        }
+
+        if(stopping)
+            break;
+
+        nanosleep(&(struct timespec){0, 5000000}, NULL);
+    }
+
+    return NULL;
+}
+
+
+bool start_result_logger(const char *path, double interval)
+{
+    if(atomic_load(&running))
+        return true;
+
+    out = path == NULL ? stdout : fopen(path, "a");
+    if(out == NULL)
+        return false;
+
+    min_interval = interval;
+    atomic_store(&head, 0);
+    atomic_store(&tail, 0);
+    atomic_store(&running, true);
+
+    if(pthread_create(&thread, NULL, logger_loop, NULL) != 0)
+    {
+        atomic_store(&running, false);
+        if(out != stdout)
+            fclose(out);
+        out = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+
+bool log_model_result(MLP *mlp)
+{
+    if(!atomic_load(&running))
+        return false;
+
+    size_t h = atomic_load_explicit(&head, memory_order_relaxed);
+    size_t t = atomic_load_explicit(&tail, memory_order_acquire);
+    if(h - t >= LOG_CAPACITY)
+        return false;
+
+    LogEntry *e = &ring[h % LOG_CAPACITY];
+    mlp_probabilities(mlp);
+    e->result = mlp->result;
+
+    Vector *output = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
+    e->size = min(output->size, (size_t) LOG_MAX_CLASSES);
+    for(size_t i = 0; i < e->size; i++)
+        e->prob[i] = get_vector_as_type(output, i, Node).output;
+
+    atomic_store_explicit(&head, h+1, memory_order_release);
+
+    return true;
+}
+
+
+void stop_result_logger()
+{
+    if(!atomic_load(&running))
+        return;
+
+    atomic_store(&running, false);
+    pthread_join(thread, NULL);
+
+    if(out != stdout)
+        fclose(out);
+    out = NULL;
+}
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include "raylib.h"
 
 #include "vector.h"
@@ -9,13 +10,43 @@
 #include "filehandler.h"
 #include "snippets.h"
 #include "gui.h"
+#include "logger.h"
+#include "inference.h"
+#include "compare.h"
+#include "recorder.h"
+#include "threadpool.h"
+#include "cli.h"
 
 #define WIDTH 1000
 #define HEIGHT 600
 #define APP_NAME "Rajzfelismerő"
+#define LOG_INTERVAL 0.1
 
 
-int main(){
+int main(int argc, char *argv[]){
+    if(is_cli(argc, argv))
+    {
+        // headless modes can process more data than debugmalloc allows in a single block by default
+        debugmalloc_max_block_size(1 << 30);
+        return run_cli(argc, argv);
+    }
+
+    // in on-demand mode frames are only drawn after input events or while a result is pending
+    bool on_demand = false;
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--on-demand") == 0)
+            on_demand = true;
+        // the strokes on the drawing board can be replayed without a window later
+        else if(strcmp(argv[i], "--record") == 0)
+        {
+            if(i+1 >= argc)
+                fprintf(stderr, "--record needs the path of the recording\n");
+            else if(!start_recording(argv[++i]))
+                fprintf(stderr, "Couldn't open '%s' for recording\n", argv[i]);
+        }
+    }
+
     InitWindow(WIDTH, HEIGHT, APP_NAME);
     
     SetTargetFPS( GetMonitorRefreshRate( GetCurrentMonitor() ) );
@@ -29,11 +60,18 @@ int main(){
 
     Camera2D camera = {{0, 0}, {0, 0}, 0, 1.0f};
 
+    start_result_logger(NULL, LOG_INTERVAL);
+    // the pool lives as long as the window, every background job shares it
+    start_thread_pool(0);
+
 
     bool running = true;
 
     while(running && (!WindowShouldClose() || IsKeyPressed(KEY_ESCAPE)))
     {
+        GUISTATE prevstate = state;
+        bool pending = inference_busy() || comparison_busy();
+
         BeginDrawing();
         ClearBackground(WHITE);
 
@@ -56,13 +94,30 @@ int main(){
         
         DrawFPS(10, 5);
 
+        if(on_demand)
+        {
+            // keep drawing frames until a new state or an asynchronous result was drawn,
+            // otherwise EndDrawing() sleeps until the next input event
+            if(state != prevstate || pending || inference_busy() || comparison_busy())
+                DisableEventWaiting();
+            else
+                EnableEventWaiting();
+        }
+
         EndDrawing();
     }
 
     
+    stop_inference_worker();
+    stop_comparison();
+    stop_thread_pool();
+    stop_result_logger();
+    stop_recording();
     free_mlp(&mlp);
     free_loaded_mlp_vector(&paths, &names);
     free_file_dialog();
+    free_draw_gui();
+    free_simulation_gui();
 
     CloseWindow();
 }
@@ -50,6 +50,8 @@ MLP create_mlp(size_t x, size_t y, size_t kx, size_t ky, const char *name, size_
     m.canvas = create_canvas(x, y);
     m.draw_canvas = create_canvas(x, y);
     m.result = 0;
+    m.probabilities = false;
+    m.runs = 0;
 
     return m;
 }
@@ -165,14 +167,14 @@ void free_mlp(MLP *mlp)
  * 
  * \returns The maximum value inside the given area.
  */
-static double maxpool2d(MLP *mlp, size_t x, size_t y, size_t width, size_t height)
+static double maxpool2d(const MLP *mlp, size_t x, size_t y, size_t width, size_t height)
 {
     double m = get_canvas_xy(&mlp->draw_canvas, x, y)/255.0;
     for(size_t i = x; i < x+width; i++)
     {
         for(size_t j = y; j < y+height; j++)
         {
-            m = max(m, get_canvas_xy(&mlp->canvas, i, j)/255.0);
+            m = max(m, get_canvas_xy(&mlp->draw_canvas, i, j)/255.0);
         }
     }
 
@@ -180,24 +182,64 @@ static double maxpool2d(MLP *mlp, size_t x, size_t y, size_t width, size_t heigh
 }
 
 
-void load_mlp_input(MLP *mlp)
+void pool_mlp_input(const MLP *mlp, double *out)
 {
     size_t n1 = mlp->x/mlp->kx;
     size_t n2 = mlp->y/mlp->ky;
 
-    Vector *vx = &get_vector_as_type(&mlp->layers, 0, Vector);
+    for(size_t x = 0; x < n1; x++)
+    {
+        for(size_t y = 0; y < n2; y++)
+        {
+            out[y*n1 + x] = maxpool2d(mlp, x*mlp->kx, y*mlp->ky, mlp->kx, mlp->ky);
+        }
+    }
+}
+
+
+void pool_pixels(const MLP *mlp, const unsigned char *pixels, size_t width, size_t height, double *out)
+{
+    size_t n1 = mlp->x/mlp->kx;
+    size_t n2 = mlp->y/mlp->ky;
 
     for(size_t x = 0; x < n1; x++)
     {
         for(size_t y = 0; y < n2; y++)
         {
-            Node *vy = &get_vector_as_type(vx, y*n1 + x, Node);
-            vy->value = maxpool2d(mlp, x*mlp->kx, y*mlp->ky, mlp->kx, mlp->ky);
+            unsigned char m = 0;
+            for(size_t j = y*mlp->ky; j < (y+1)*mlp->ky; j++)
+            {
+                const unsigned char *row = pixels + (j*height/mlp->y)*width;
+                for(size_t i = x*mlp->kx; i < (x+1)*mlp->kx; i++)
+                    m = max(m, row[i*width/mlp->x]);
+            }
+            out[y*n1 + x] = m/255.0;
         }
     }
 }
 
 
+void set_mlp_input(MLP *mlp, const double *in)
+{
+    Vector *input = &get_vector_as_type(&mlp->layers, 0, Vector);
+
+    for(size_t i = 0; i < input->size; i++)
+    {
+        Node *node = &get_vector_as_type(input, i, Node);
+        node->value = in[i];
+    }
+}
+
+
+void load_mlp_input(MLP *mlp)
+{
+    double in[(mlp->x/mlp->kx) * (mlp->y/mlp->ky)];
+
+    pool_mlp_input(mlp, in);
+    set_mlp_input(mlp, in);
+}
+
+
 /**
  * Calculates and sets a given Node's output
  * based on its value, bias and activation function.
@@ -238,31 +280,59 @@ static void run_node(Vector *layer, Node *node, size_t node_index)
  * Applies softmax to a Vector of Nodes.
  * 
  * Each Node's output will be overridden by the probability associated with its current output.
+ * The outputs are gathered into a contiguous array first, so the passes over them can be vectorized.
  * 
  * \param layer Pointer to the target Vector.
  */
-static void softmax(Vector *layer)
+static void softmax_layer(Vector *layer)
 {
-    double sum = 0;
-    for(size_t i = 0; i < layer->size; i++)
-    {
-        Node *n = &get_vector_as_type(layer, i, Node);
-        n->output = exp(n->output);
-        sum += n->output;
-    }
+    size_t size = layer->size;
+    if(size == 0) return;
 
-    for(size_t i = 0; i < layer->size; i++)
+    Node *nodes = (Node*) layer->arr;
+    double v[size];
+
+    for(size_t i = 0; i < size; i++)
+        v[i] = nodes[i].output;
+
+    softmax(v, size, v);
+
+    for(size_t i = 0; i < size; i++)
+        nodes[i].output = v[i];
+}
+
+
+/**
+ * Finds the index of the largest output in a Vector of Nodes.
+ * Softmax keeps the order of the outputs, so this works on raw outputs and probabilities alike.
+ * 
+ * \param layer Pointer to the target Vector.
+ * 
+ * \returns The index of the first Node with the largest output.
+ */
+static size_t argmax(const Vector *layer)
+{
+    const Node *nodes = (const Node*) layer->arr;
+
+    size_t ind = 0;
+    for(size_t i = 1; i < layer->size; i++)
     {
-        Node *n = &get_vector_as_type(layer, i, Node);
-        n->output = n->output/sum;
+        if(nodes[i].output > nodes[ind].output)
+            ind = i;
     }
+
+    return ind;
 }
 
 
-void run_mlp(MLP *mlp)
+/**
+ * Runs the MLP model in a simple feed-forward manner without applying softmax to the output layer.
+ * 
+ * \param mlp Pointer to the target MLP.
+ */
+static void feed_forward(MLP *mlp)
 {
     Vector *input = &get_vector_as_type(&mlp->layers, 0, Vector);
-    Vector *output = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
     for(size_t i = 0; i < input->size; i++)
     {
         Node *node = &get_vector_as_type(input, i, Node);
@@ -280,5 +350,105 @@ void run_mlp(MLP *mlp)
         }
     }
 
-    softmax(output);
+    mlp->probabilities = false;
+    mlp->runs++;
+}
+
+
+void run_mlp(MLP *mlp)
+{
+    Vector *output = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
+
+    feed_forward(mlp);
+    mlp->result = argmax(output);
+
+    mlp_probabilities(mlp);
+}
+
+
+size_t run_mlp_argmax(MLP *mlp)
+{
+    Vector *output = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
+
+    feed_forward(mlp);
+    mlp->result = argmax(output);
+
+    return mlp->result;
+}
+
+
+size_t topk(const double *values, size_t size, size_t k, size_t *out_idx, double *out_values)
+{
+    k = min(k, size);
+
+    // insertion into the sorted list of the current k best
+    size_t found = 0;
+    for(size_t i = 0; i < size; i++)
+    {
+        size_t pos = found;
+        while(pos > 0 && values[i] > values[out_idx[pos-1]])
+            pos--;
+
+        if(pos >= k)
+            continue;
+
+        for(size_t j = min(found, k-1); j > pos; j--)
+            out_idx[j] = out_idx[j-1];
+
+        out_idx[pos] = i;
+        found = min(found+1, k);
+    }
+
+    if(out_values != NULL)
+    {
+        for(size_t i = 0; i < found; i++)
+            out_values[i] = values[out_idx[i]];
+    }
+
+    return found;
+}
+
+
+void softmax(const double *values, size_t size, double *out)
+{
+    if(size == 0) return;
+
+    double m = values[0];
+    for(size_t i = 1; i < size; i++)
+        m = values[i] > m ? values[i] : m;
+
+    double sum = 0;
+    for(size_t i = 0; i < size; i++)
+    {
+        out[i] = exp(values[i] - m);
+        sum += out[i];
+    }
+
+    double inv = 1.0/sum;
+    for(size_t i = 0; i < size; i++)
+        out[i] *= inv;
+}
+
+
+size_t mlp_topk(MLP *mlp, size_t k, size_t *out_idx, double *out_prob)
+{
+    if(out_prob != NULL)
+        mlp_probabilities(mlp);
+
+    Vector *output = &get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector);
+    const Node *nodes = (const Node*) output->arr;
+    double outputs[output->size];
+    for(size_t i = 0; i < output->size; i++)
+        outputs[i] = nodes[i].output;
+
+    return topk(outputs, output->size, k, out_idx, out_prob);
+}
+
+
+void mlp_probabilities(MLP *mlp)
+{
+    if(mlp->probabilities) return;
+
+    softmax_layer(&get_vector_as_type(&mlp->layers, mlp->layers.size-1, Vector));
+    mlp->probabilities = true;
 }
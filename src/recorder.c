@@ -0,0 +1,155 @@
+#include "debugmalloc.h"
+#include "recorder.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "canvas.h"
+#include "stats.h"
+
+/** The longest line of a recording. */
+#define RECORDING_LINE 256
+
+
+/** The open recording, NULL if there is none. */
+static FILE *recording = NULL;
+/** The time when the recording started. */
+static double recording_start = 0;
+/** The last recorded Canvas size. */
+static size_t recorded_x = 0, recorded_y = 0;
+
+/** The names of the events in the recordings, indexed by STROKEEVENT. */
+static const char *event_names[] = {"canvas", "stroke", "release", "clear"};
+
+
+bool start_recording(const char *path)
+{
+    stop_recording();
+
+    recording = fopen(path, "w");
+    if(recording == NULL)
+        return false;
+
+    fprintf(recording, "# time event [tool eraser radius from_x from_y to_x to_y | width height]\n");
+    recording_start = now_seconds();
+    recorded_x = recorded_y = 0;
+
+    return true;
+}
+
+
+void record_stroke(const MLP *mlp, Vector2 from, Vector2 to, TOOL tool, bool eraser, int radius)
+{
+    if(recording == NULL)
+        return;
+
+    double time = now_seconds() - recording_start;
+    if(mlp->x != recorded_x || mlp->y != recorded_y)
+    {
+        fprintf(recording, "%.6lf %s %zu %zu\n", time, event_names[CANVAS], mlp->x, mlp->y);
+        recorded_x = mlp->x;
+        recorded_y = mlp->y;
+    }
+
+    fprintf(recording, "%.6lf %s %s %d %d %d %d %d %d\n", time, event_names[STROKE], tool == PENCIL ? "pencil" : "brush",
+        eraser, radius, (int) from.x, (int) from.y, (int) to.x, (int) to.y);
+}
+
+
+void record_event(STROKEEVENT type)
+{
+    if(recording == NULL)
+        return;
+
+    fprintf(recording, "%.6lf %s\n", now_seconds() - recording_start, event_names[type]);
+}
+
+
+void stop_recording()
+{
+    if(recording == NULL)
+        return;
+
+    fclose(recording);
+    recording = NULL;
+}
+
+
+bool read_recording(const char *path, Vector *events)
+{
+    FILE *f = fopen(path, "r");
+    if(f == NULL)
+        return false;
+
+    bool ok = true;
+    char line[RECORDING_LINE];
+    while(ok && fgets(line, sizeof(line), f) != NULL)
+    {
+        char name[16];
+        int offset = 0;
+        StrokeEvent e = {0, CANVAS, BRUSH, false, 0, {0, 0}, {0, 0}};
+
+        if(line[0] == '#' || sscanf(line, "%15s", name) != 1)
+            continue;
+
+        if(sscanf(line, "%lf %15s %n", &e.time, name, &offset) != 2)
+        {
+            ok = false;
+            continue;
+        }
+
+        const char *args = line + offset;
+        if(strcmp(name, event_names[CANVAS]) == 0)
+        {
+            int x, y;
+            e.type = CANVAS;
+            ok = sscanf(args, "%d %d", &x, &y) == 2 && x > 0 && y > 0;
+            e.to = (Vector2) {x, y};
+        }
+        else if(strcmp(name, event_names[STROKE]) == 0)
+        {
+            char tool[16];
+            int eraser, fx, fy, tx, ty;
+            e.type = STROKE;
+            ok = sscanf(args, "%15s %d %d %d %d %d %d", tool, &eraser, &e.radius, &fx, &fy, &tx, &ty) == 7 && e.radius > 0
+                && (strcmp(tool, "brush") == 0 || strcmp(tool, "pencil") == 0);
+            e.tool = strcmp(tool, "pencil") == 0 ? PENCIL : BRUSH;
+            e.eraser = eraser != 0;
+            e.from = (Vector2) {fx, fy};
+            e.to = (Vector2) {tx, ty};
+        }
+        else if(strcmp(name, event_names[RELEASE]) == 0)
+            e.type = RELEASE;
+        else if(strcmp(name, event_names[CLEAR]) == 0)
+            e.type = CLEAR;
+        else
+            ok = false;
+
+        if(ok)
+            push_vector(events, &e);
+    }
+    fclose(f);
+
+    return ok;
+}
+
+
+bool apply_stroke_event(MLP *mlp, const StrokeEvent *e)
+{
+    Vector2 from = e->from, to = e->to;
+
+    switch(e->type)
+    {
+        case STROKE:
+            draw_stroke(mlp, &from, &to, e->tool, e->eraser, e->radius);
+            return true;
+        case RELEASE:
+            end_stroke(mlp);
+            return false;
+        case CLEAR:
+            clear_canvas(&mlp->canvas);
+            clear_canvas(&mlp->draw_canvas);
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,201 @@
+#include "debugmalloc.h"
+#include "registry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "errors.h"
+#include "vector.h"
+#include "filehandler.h"
+#include "snippets.h"
+#include "raylib.h"
+
+
+/** The current entries as 'ModelEntry*' values. */
+static Vector entries = {NULL, sizeof(ModelEntry*), 0, 0};
+
+
+/**
+ * Queries the modification time and the size of a file.
+ * GetFileModTime() only has a resolution of a second, so a model rewritten right after it was read would look unchanged.
+ * 
+ * \param path Path to the file.
+ * \param mtime Pointer to store the modification time in, in nanoseconds where the platform has them.
+ * \param size Pointer to store the size in. Both are set to -1 if the file doesn't exist.
+ */
+static void file_stamp(const char *path, long long *mtime, long long *size)
+{
+    struct stat st;
+    if(stat(path, &st) != 0)
+    {
+        *mtime = -1;
+        *size = -1;
+        return;
+    }
+
+#ifdef __linux__
+    *mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#else
+    *mtime = st.st_mtime * 1000000000LL;
+#endif
+    *size = st.st_size;
+}
+
+
+/**
+ * Reads a model file into a new entry.
+ * 
+ * \param path Path to the model file.
+ * 
+ * \returns Pointer to the entry with a single reference, NULL if the model couldn't be read.
+ */
+static ModelEntry* load_entry(const char *path)
+{
+    long long mtime, size;
+    file_stamp(path, &mtime, &size);
+    ReadResult read = read_model(path, GetFileNameWithoutExt(path));
+    if(read.status != SUCCESS)
+    {
+        fprintf(stderr, "Couldn't read the model '%s' (status %d)\n", path, read.status);
+        return NULL;
+    }
+
+    ModelEntry *entry = (ModelEntry*) malloc(sizeof(ModelEntry));
+    if(entry == NULL)
+        exit(ERR_NULLPOINTER);
+
+    *entry = (ModelEntry) {read.model, strclone(path), mtime, size, 1, false};
+    return entry;
+}
+
+
+/**
+ * Finds the index of a current entry by its name.
+ * 
+ * \param name Name of the model.
+ * 
+ * \returns The index, or the number of entries if there is no such model.
+ */
+static size_t find_entry(const char *name)
+{
+    for(size_t i = 0; i < entries.size; i++)
+    {
+        if(strcmp(get_vector_as_type(&entries, i, ModelEntry*)->mlp.name, name) == 0)
+            return i;
+    }
+
+    return entries.size;
+}
+
+
+/**
+ * Replaces a current entry with a new version and retires the old one.
+ * 
+ * \param i Index of the entry.
+ * \param entry Pointer to the new entry.
+ */
+static void swap_entry(size_t i, ModelEntry *entry)
+{
+    ModelEntry **slot = &get_vector_as_type(&entries, i, ModelEntry*);
+    ModelEntry *old = *slot;
+
+    *slot = entry;
+    old->retired = true;
+    release_model(old);
+}
+
+
+bool register_model(const char *path)
+{
+    ModelEntry *entry = load_entry(path);
+    if(entry == NULL)
+        return false;
+
+    if(entries.arr == NULL)
+        entries = create_vector(4, sizeof(ModelEntry*), false);
+
+    size_t i = find_entry(entry->mlp.name);
+    if(i < entries.size)
+        swap_entry(i, entry);
+    else
+        push_vector(&entries, &entry);
+
+    return true;
+}
+
+
+ModelEntry* acquire_model(const char *name)
+{
+    if(entries.size == 0)
+        return NULL;
+
+    size_t i = (name == NULL || name[0] == '\0') ? 0 : find_entry(name);
+    if(i == entries.size)
+        return NULL;
+
+    ModelEntry *entry = get_vector_as_type(&entries, i, ModelEntry*);
+    entry->refs++;
+
+    return entry;
+}
+
+
+void release_model(ModelEntry *entry)
+{
+    if(--entry->refs > 0)
+        return;
+
+    free_mlp(&entry->mlp);
+    free(entry->path);
+    free(entry);
+}
+
+
+size_t reload_models()
+{
+    size_t swapped = 0;
+    for(size_t i = 0; i < entries.size; i++)
+    {
+        ModelEntry *old = get_vector_as_type(&entries, i, ModelEntry*);
+        long long mtime, size;
+        file_stamp(old->path, &mtime, &size);
+        if(mtime == old->mtime && size == old->size)
+            continue;
+
+        ModelEntry *entry = load_entry(old->path);
+        if(entry == NULL)
+            continue;
+
+        swap_entry(i, entry);
+        swapped++;
+    }
+
+    return swapped;
+}
+
+
+size_t registered_model_count()
+{
+    return entries.size;
+}
+
+
+ModelEntry* get_registered_model(size_t i)
+{
+    return get_vector_as_type(&entries, i, ModelEntry*);
+}
+
+
+void free_registry()
+{
+    for(size_t i = 0; i < entries.size; i++)
+    {
+        ModelEntry *entry = get_vector_as_type(&entries, i, ModelEntry*);
+        entry->retired = true;
+        release_model(entry);
+    }
+
+    free_vector(&entries);
+    entries = (Vector) {NULL, sizeof(ModelEntry*), 0, 0};
+}
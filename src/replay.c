@@ -0,0 +1,133 @@
+#include "debugmalloc.h"
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vector.h"
+#include "mlp.h"
+#include "filehandler.h"
+#include "recorder.h"
+#include "stats.h"
+#include "raylib.h"
+
+
+int run_replay(int argc, char *argv[])
+{
+    const char *path = NULL, *model = NULL;
+    bool realtime = false, bad = false;
+    double max_p99 = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i+1 < argc;
+
+        if(strcmp(argv[i], "--replay") == 0 && has_value)
+            path = argv[++i];
+        else if(strcmp(argv[i], "--model") == 0 && has_value)
+            model = argv[++i];
+        else if(strcmp(argv[i], "--realtime") == 0)
+            realtime = true;
+        else if(strcmp(argv[i], "--max-p99") == 0 && has_value)
+            max_p99 = atof(argv[++i]) / 1e6;
+        else
+        {
+            fprintf(stderr, "Unknown argument '%s'\n", argv[i]);
+            bad = true;
+        }
+    }
+
+    if(bad || path == NULL || model == NULL)
+    {
+        fprintf(stderr, "Usage: --replay strokes.txt --model model.mlpmodel [--realtime] [--max-p99 us]\n");
+        return 1;
+    }
+
+    Vector events = create_vector(256, sizeof(StrokeEvent), false);
+    if(!read_recording(path, &events))
+    {
+        fprintf(stderr, "Couldn't read the recording '%s'\n", path);
+        free_vector(&events);
+        return 1;
+    }
+
+    ReadResult read = read_model(model, GetFileNameWithoutExt(model));
+    if(read.status != SUCCESS)
+    {
+        fprintf(stderr, "Couldn't read the model '%s' (status %d)\n", model, read.status);
+        free_vector(&events);
+        return 1;
+    }
+
+    MLP *mlp = &read.model;
+    for(size_t i = 0; i < events.size; i++)
+    {
+        const StrokeEvent *e = &get_vector_as_type(&events, i, StrokeEvent);
+        if(e->type == CANVAS && (e->to.x != mlp->x || e->to.y != mlp->y))
+        {
+            fprintf(stderr, "The recording was drawn on a %.0fx%.0f Canvas, but the model's Canvas is %zux%zu\n", e->to.x, e->to.y, mlp->x, mlp->y);
+            free_mlp(mlp);
+            free_vector(&events);
+            return 1;
+        }
+    }
+
+    Vector latencies = create_vector(events.size, sizeof(double), false);
+    size_t strokes = 0;
+    bool drawn = false;
+    double start = now_seconds();
+
+    printf("stroke,time,class,probability\n");
+    for(size_t i = 0; i < events.size; i++)
+    {
+        const StrokeEvent *e = &get_vector_as_type(&events, i, StrokeEvent);
+
+        // in real time the events arrive at their recorded pace, like from the mouse
+        if(realtime)
+        {
+            double wait = e->time - (now_seconds() - start);
+            if(wait > 0)
+                nanosleep(&(struct timespec){(time_t) wait, (long) ((wait - (time_t) wait) * 1e9)}, NULL);
+        }
+
+        double t = now_seconds();
+        if(apply_stroke_event(mlp, e))
+        {
+            load_mlp_input(mlp);
+            run_mlp_argmax(mlp);
+
+            double latency = now_seconds() - t;
+            push_vector(&latencies, &latency);
+            drawn = true;
+        }
+
+        if(e->type == RELEASE && drawn)
+        {
+            size_t idx;
+            double prob;
+            mlp_topk(mlp, 1, &idx, &prob);
+            printf("%zu,%.6lf,%zu,%.6lf\n", ++strokes, e->time, idx, prob);
+            drawn = false;
+        }
+    }
+
+    Summary s = summarize(&latencies);
+    fprintf(stderr, "%zu events, %zu results, %zu strokes in %.3lf s\n", events.size, s.count, strokes, now_seconds() - start);
+    fprintf(stderr, "input-to-result latency (us): mean %.1lf, p50 %.1lf, p95 %.1lf, p99 %.1lf, max %.1lf\n",
+        s.mean*1e6, s.median*1e6, s.p95*1e6, s.p99*1e6, s.max*1e6);
+
+    int code = 0;
+    if(max_p99 > 0 && s.p99 > max_p99)
+    {
+        fprintf(stderr, "The p99 latency is above the limit of %.1lf us\n", max_p99*1e6);
+        code = 1;
+    }
+
+    free_vector(&latencies);
+    free_mlp(mlp);
+    free_vector(&events);
+    free_brush_stamps();
+
+    return code;
+}
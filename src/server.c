@@ -0,0 +1,879 @@
+#include "debugmalloc.h"
+#include "server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int run_server(int argc, char *argv[])
+{
+    fprintf(stderr, "The server mode isn't available on Windows\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <stdint.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "errors.h"
+#include "vector.h"
+#include "mlp.h"
+#include "filehandler.h"
+#include "forward.h"
+#include "registry.h"
+#include "threadpool.h"
+#include "snippets.h"
+#include "stats.h"
+#include "raylib.h"
+
+
+/** Settings of the server mode. */
+typedef struct ServerOptions {
+    /** Paths of the served models as 'const char*' values. */
+    Vector models;
+    const char *socket;
+    int port;
+    size_t batch;
+    /** The longest time a request waits for its batch to fill up, in seconds. */
+    double deadline;
+    size_t threads;
+} ServerOptions;
+
+
+/** A connected client. */
+typedef struct Client {
+    int fd;
+    /** Identifies the connection, as file descriptors are reused after closing. */
+    size_t serial;
+    /** Received bytes that don't form a whole request yet. */
+    unsigned char *in;
+    size_t in_len, in_cap;
+    /** Responses that couldn't be sent yet. */
+    unsigned char *out;
+    size_t out_len, out_cap;
+    /** Number of the client's requests waiting in a batch. */
+    size_t queued;
+    /** The batch of the waiting requests. A client only has requests in one batch at a time, so the responses keep their order. */
+    struct Batch *batch;
+    /** True if the connection should be closed, which is postponed until no client is being iterated. */
+    bool broken;
+} Client;
+
+
+/** The client that sent a request of a batch. */
+typedef struct Owner {
+    int fd;
+    size_t serial;
+} Owner;
+
+
+/** The requests collected for a model. */
+typedef struct Batch {
+    /** The model that runs the batch, acquired while the batch exists. */
+    ModelEntry *model;
+    size_t input_size;
+    size_t size;
+    /** The time when the oldest request of the batch arrived. */
+    double start;
+    double *inputs;
+    Owner *owners;
+    size_t *results;
+    double *probs;
+    /** A context for each thread of the pool, each of them runs a part of the batch. */
+    InferContext *contexts;
+    /** Number of parts the batch is split into when it's run. */
+    size_t parts;
+} Batch;
+
+
+static volatile sig_atomic_t interrupted = 0;
+static volatile sig_atomic_t reload_requested = 0;
+
+/** The connected clients as 'Client' values. */
+static Vector clients;
+static size_t next_serial = 0;
+
+/** The batch of each model that was requested, as 'Batch*' values. */
+static Vector batches;
+static size_t batch_capacity = 0;
+static size_t thread_count = 0;
+
+static size_t served = 0;
+static size_t batch_runs = 0;
+
+
+/**
+ * Stops the server's loop on SIGINT and SIGTERM.
+ */
+static void on_signal(int sig)
+{
+    interrupted = 1;
+}
+
+
+/**
+ * Requests reloading the changed models on SIGHUP.
+ */
+static void on_reload(int sig)
+{
+    reload_requested = 1;
+}
+
+
+/**
+ * Grows a byte buffer so it can hold a given number of bytes.
+ * 
+ * \param buf Pointer to the buffer.
+ * \param cap Pointer to the capacity of the buffer.
+ * \param need The required capacity.
+ */
+static void reserve(unsigned char **buf, size_t *cap, size_t need)
+{
+    if(need <= *cap)
+        return;
+
+    size_t c = *cap == 0 ? 4096 : *cap;
+    while(c < need)
+        c *= 2;
+
+    unsigned char *b = (unsigned char*) realloc(*buf, c);
+    if(b == NULL)
+        exit(ERR_NULLPOINTER);
+
+    *buf = b;
+    *cap = c;
+}
+
+
+/**
+ * Writes a 32-bit integer in big-endian byte order.
+ * 
+ * \param p Pointer to the first byte.
+ * \param n The integer.
+ */
+static void write_be32(unsigned char *p, uint32_t n)
+{
+    p[0] = n >> 24;
+    p[1] = n >> 16;
+    p[2] = n >> 8;
+    p[3] = n;
+}
+
+
+/**
+ * Finds the client that sent a request.
+ * 
+ * \param owner Pointer to the request's owner.
+ * 
+ * \returns Pointer to the client, NULL if it has disconnected since.
+ */
+static Client* find_client(const Owner *owner)
+{
+    for(size_t i = 0; i < clients.size; i++)
+    {
+        Client *c = &get_vector_as_type(&clients, i, Client);
+        if(c->fd == owner->fd && c->serial == owner->serial)
+            return c;
+    }
+
+    return NULL;
+}
+
+
+/**
+ * Sends as much of a client's queued responses as the socket takes without blocking.
+ * 
+ * \param c Pointer to the client.
+ */
+static void flush_client(Client *c)
+{
+    size_t sent = 0;
+    while(sent < c->out_len)
+    {
+        ssize_t n = send(c->fd, c->out + sent, c->out_len - sent, MSG_NOSIGNAL);
+        if(n < 0)
+        {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                c->broken = true;
+            if(errno != EINTR)
+                break;
+            continue;
+        }
+        sent += n;
+    }
+
+    memmove(c->out, c->out + sent, c->out_len - sent);
+    c->out_len -= sent;
+}
+
+
+/**
+ * Creates the batch of a model.
+ * 
+ * \param model Pointer to the acquired model, which is released with the batch.
+ * 
+ * \returns Pointer to the new batch.
+ */
+static Batch* create_batch(ModelEntry *model)
+{
+    const MLP *mlp = &model->mlp;
+    size_t input_size = (mlp->x/mlp->kx) * (mlp->y/mlp->ky);
+
+    // everything is allocated up front, the pool's threads mustn't use debugmalloc
+    Batch *b = (Batch*) malloc(sizeof(Batch));
+    if(b == NULL)
+        exit(ERR_NULLPOINTER);
+
+    *b = (Batch) {
+        model, input_size, 0, 0,
+        (double*) malloc(batch_capacity * input_size * sizeof(double)),
+        (Owner*) malloc(batch_capacity * sizeof(Owner)),
+        (size_t*) malloc(batch_capacity * sizeof(size_t)),
+        (double*) malloc(batch_capacity * sizeof(double)),
+        (InferContext*) malloc(thread_count * sizeof(InferContext)),
+        0
+    };
+    if(b->inputs == NULL || b->owners == NULL || b->results == NULL || b->probs == NULL || b->contexts == NULL)
+        exit(ERR_NULLPOINTER);
+
+    for(size_t i = 0; i < thread_count; i++)
+        b->contexts[i] = create_batch_context(mlp, (batch_capacity + thread_count-1) / thread_count);
+
+    return b;
+}
+
+
+/**
+ * Frees a batch and releases its model.
+ * 
+ * \param b Pointer to the batch.
+ */
+static void free_batch(Batch *b)
+{
+    for(size_t i = 0; i < thread_count; i++)
+        free_infer_context(&b->contexts[i]);
+
+    free(b->contexts);
+    free(b->inputs);
+    free(b->owners);
+    free(b->results);
+    free(b->probs);
+    release_model(b->model);
+    free(b);
+}
+
+
+/**
+ * Finds the batch of a model, creating it on the first request.
+ * 
+ * \param name Name of the model, an empty string for the default model.
+ * 
+ * \returns Pointer to the batch of the model's current version, NULL if there is no such model.
+ */
+static Batch* find_batch(const char *name)
+{
+    ModelEntry *model = acquire_model(name);
+    if(model == NULL)
+        return NULL;
+
+    for(size_t i = 0; i < batches.size; i++)
+    {
+        Batch *b = get_vector_as_type(&batches, i, Batch*);
+        if(b->model == model)
+        {
+            release_model(model);
+            return b;
+        }
+    }
+
+    Batch *b = create_batch(model);
+    push_vector(&batches, &b);
+
+    return b;
+}
+
+
+/**
+ * Queues a response to a client.
+ * 
+ * \param c Pointer to the client.
+ * \param result Index of the winning class.
+ * \param prob Probability of the winning class.
+ */
+static void queue_response(Client *c, uint32_t result, double prob)
+{
+    reserve(&c->out, &c->out_cap, c->out_len + RESPONSE_SIZE);
+    write_be32(c->out + c->out_len, result);
+    write_be32(c->out + c->out_len + 4, prob*1000000 + 0.5);
+    c->out_len += RESPONSE_SIZE;
+}
+
+
+/**
+ * Runs a part of a batch. Called by the thread pool.
+ * 
+ * \param arg Pointer to the batch.
+ * \param index Index of the part.
+ */
+static void run_part(void *arg, size_t index)
+{
+    Batch *b = (Batch*) arg;
+    size_t first = b->size*index/b->parts;
+    size_t last = b->size*(index+1)/b->parts;
+    if(first == last)
+        return;
+
+    InferContext *ctx = &b->contexts[index];
+    infer_mlp_batch(ctx, b->inputs + first*b->input_size, last-first, b->results + first);
+
+    double prob[ctx->outputs];
+    for(size_t i = first; i < last; i++)
+    {
+        infer_batch_probabilities(ctx, i-first, prob);
+        b->probs[i] = prob[b->results[i]];
+    }
+}
+
+
+/**
+ * Runs a batch in a single forward pass, split between the threads of the pool,
+ * and sends the responses to the clients.
+ * 
+ * \param b Pointer to the batch.
+ */
+static void flush_batch(Batch *b)
+{
+    if(b->size == 0)
+        return;
+
+    b->parts = min(thread_count, b->size);
+    run_parallel(run_part, b, b->parts);
+
+    for(size_t i = 0; i < b->size; i++)
+    {
+        Client *c = find_client(&b->owners[i]);
+        if(c == NULL)
+            continue;
+
+        queue_response(c, b->results[i], b->probs[i]);
+        c->queued = 0;
+        c->batch = NULL;
+    }
+
+    for(size_t i = 0; i < clients.size; i++)
+    {
+        Client *c = &get_vector_as_type(&clients, i, Client);
+        if(c->out_len > 0 && !c->broken)
+            flush_client(c);
+    }
+
+    served += b->size;
+    batch_runs++;
+    b->size = 0;
+}
+
+
+/**
+ * Runs every batch that isn't empty.
+ */
+static void flush_batches()
+{
+    for(size_t i = 0; i < batches.size; i++)
+        flush_batch(get_vector_as_type(&batches, i, Batch*));
+}
+
+
+/**
+ * Swaps in the models whose files have changed.
+ * The batches of the old versions are run and freed, so no request is lost.
+ */
+static void reload()
+{
+    size_t swapped = reload_models();
+
+    for(size_t i = batches.size; i > 0; i--)
+    {
+        Batch *b = get_vector_as_type(&batches, i-1, Batch*);
+        if(!b->model->retired)
+            continue;
+
+        flush_batch(b);
+        free_batch(b);
+        erase_vector(&batches, i-1);
+    }
+
+    fprintf(stderr, "Reloaded %zu models\n", swapped);
+}
+
+
+/**
+ * Takes the whole requests out of a client's received bytes and adds them to the batches of their models.
+ * A batch is run whenever it fills up.
+ * 
+ * \param c Pointer to the client.
+ */
+static void parse_requests(Client *c)
+{
+    size_t pos = 0;
+    while(c->in_len - pos >= REQUEST_HEADER)
+    {
+        const unsigned char *p = c->in + pos;
+        size_t name_len = p[0];
+        if(c->in_len - pos < REQUEST_HEADER + name_len)
+            break;
+
+        char name[name_len + 1];
+        memcpy(name, p + 1, name_len);
+        name[name_len] = '\0';
+
+        p += 1 + name_len;
+        size_t w = (size_t) p[0] << 8 | p[1];
+        size_t h = (size_t) p[2] << 8 | p[3];
+        p += 4;
+
+        if(w == 0 || h == 0 || w > REQUEST_MAX_SIDE || h > REQUEST_MAX_SIDE || memchr(name, '\0', name_len) != NULL)
+        {
+            c->broken = true;
+            break;
+        }
+
+        size_t size = REQUEST_HEADER + name_len + w*h;
+        if(c->in_len - pos < size)
+            break;
+        pos += size;
+
+        Batch *b = find_batch(name);
+
+        // the earlier requests are answered first, so the responses keep the order of the requests
+        if(c->queued > 0 && c->batch != b)
+            flush_batch(c->batch);
+
+        if(b == NULL)
+        {
+            queue_response(c, RESPONSE_ERROR, 0);
+            flush_client(c);
+            continue;
+        }
+
+        pool_pixels(&b->model->mlp, p, w, h, b->inputs + b->size*b->input_size);
+        b->owners[b->size] = (Owner) {c->fd, c->serial};
+        if(b->size++ == 0)
+            b->start = now_seconds();
+
+        c->queued++;
+        c->batch = b;
+
+        if(b->size == batch_capacity)
+            flush_batch(b);
+    }
+
+    memmove(c->in, c->in + pos, c->in_len - pos);
+    c->in_len -= pos;
+}
+
+
+/**
+ * Reads everything a client has sent without blocking and processes its requests.
+ * 
+ * \param c Pointer to the client.
+ */
+static void read_client(Client *c)
+{
+    while(!c->broken)
+    {
+        reserve(&c->in, &c->in_cap, c->in_len + 4096);
+
+        ssize_t n = recv(c->fd, c->in + c->in_len, c->in_cap - c->in_len, 0);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if(n <= 0)
+        {
+            c->broken = true;
+            break;
+        }
+
+        c->in_len += n;
+        parse_requests(c);
+    }
+}
+
+
+/**
+ * Accepts every pending connection of a listening socket.
+ * 
+ * \param listener The listening socket.
+ * \param tcp True if the socket is a TCP socket.
+ */
+static void accept_clients(int listener, bool tcp)
+{
+    while(true)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if(fd < 0)
+            break;
+
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        if(tcp)
+        {
+            // the responses are tiny, they shouldn't wait for more data
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        Client c = {fd, next_serial++, NULL, 0, 0, NULL, 0, 0, 0, NULL, false};
+        push_vector(&clients, &c);
+    }
+}
+
+
+/**
+ * Closes and removes the clients whose connection is broken.
+ */
+static void remove_broken_clients()
+{
+    for(size_t i = clients.size; i > 0; i--)
+    {
+        Client *c = &get_vector_as_type(&clients, i-1, Client);
+        if(!c->broken)
+            continue;
+
+        close(c->fd);
+        free(c->in);
+        free(c->out);
+        erase_vector(&clients, i-1);
+    }
+}
+
+
+/**
+ * Opens a listening UNIX domain socket.
+ * 
+ * \param path Path of the socket. Any existing file at the path is removed.
+ * 
+ * \returns The socket, -1 if it couldn't be opened.
+ */
+static int listen_unix(const char *path)
+{
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0)
+        return -1;
+
+    unlink(path);
+    if(bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+
+/**
+ * Opens a listening TCP socket on localhost.
+ * 
+ * \param port The port to listen on.
+ * 
+ * \returns The socket, -1 if it couldn't be opened.
+ */
+static int listen_tcp(int port)
+{
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+        return -1;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if(bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+
+/**
+ * Parses the command line arguments of the server mode.
+ * 
+ * \param argc Number of command line arguments.
+ * \param argv The command line arguments.
+ * \param opt Pointer to the options to fill. Its models Vector has to be freed by the caller.
+ * 
+ * \returns True if the arguments were valid.
+ */
+static bool parse_server_options(int argc, char *argv[], ServerOptions *opt)
+{
+    *opt = (ServerOptions) {create_vector(1, sizeof(const char*), false), SERVER_SOCKET, 0, 32, 0.002, 0};
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i+1 < argc;
+
+        if(strcmp(argv[i], "--serve") == 0 && has_value)
+            push_vector(&opt->models, &argv[++i]);
+        else if(strcmp(argv[i], "--socket") == 0 && has_value)
+            opt->socket = argv[++i];
+        else if(strcmp(argv[i], "--port") == 0 && has_value)
+        {
+            size_t port;
+            if(!parse_size(argv[++i], &port) || port > 65535)
+                return false;
+            opt->port = (int) port;
+        }
+        else if(strcmp(argv[i], "--batch") == 0 && has_value)
+        {
+            if(!parse_size(argv[++i], &opt->batch))
+                return false;
+        }
+        else if(strcmp(argv[i], "--deadline") == 0 && has_value)
+        {
+            const char *value = argv[++i];
+            char *end;
+            opt->deadline = strtod(value, &end) / 1000;
+            if(end == value || *end != '\0')
+                return false;
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && has_value)
+        {
+            if(!parse_size(argv[++i], &opt->threads))
+                return false;
+        }
+        else
+            return false;
+    }
+
+    return opt->models.size > 0 && opt->deadline >= 0;
+}
+
+
+/**
+ * Checks if waiting for more requests is pointless, because every client already has a request in a batch.
+ * Clients that wait for each response before sending the next request can't add anything before the deadline.
+ * 
+ * \returns True if every connected client has a request in a batch.
+ */
+static bool batches_complete()
+{
+    for(size_t i = 0; i < clients.size; i++)
+    {
+        Client *c = &get_vector_as_type(&clients, i, Client);
+        if(c->queued == 0 && !c->broken)
+            return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * Queries the arrival of the oldest request that is waiting in a batch.
+ * 
+ * \returns The time of the oldest request, a negative value if every batch is empty.
+ */
+static double oldest_request()
+{
+    double oldest = -1;
+    for(size_t i = 0; i < batches.size; i++)
+    {
+        Batch *b = get_vector_as_type(&batches, i, Batch*);
+        if(b->size > 0 && (oldest < 0 || b->start < oldest))
+            oldest = b->start;
+    }
+
+    return oldest;
+}
+
+
+/**
+ * Waits for the sockets and handles them until the server is interrupted.
+ * 
+ * \param listeners The listening sockets.
+ * \param tcp Whether each listening socket is a TCP socket.
+ * \param count Number of listening sockets.
+ * \param deadline The longest time a request waits for its batch, in seconds.
+ */
+static void serve(const int *listeners, const bool *tcp, size_t count, double deadline)
+{
+    while(!interrupted)
+    {
+        if(reload_requested)
+        {
+            reload_requested = 0;
+            reload();
+        }
+
+        size_t n = clients.size;
+        struct pollfd fds[count + n];
+
+        for(size_t i = 0; i < count; i++)
+            fds[i] = (struct pollfd) {listeners[i], POLLIN, 0};
+        for(size_t i = 0; i < n; i++)
+        {
+            Client *c = &get_vector_as_type(&clients, i, Client);
+            fds[count + i] = (struct pollfd) {c->fd, POLLIN | (c->out_len > 0 ? POLLOUT : 0), 0};
+        }
+
+        int timeout = 1000;
+        double oldest = oldest_request();
+        if(oldest >= 0)
+            timeout = max(0.0, (oldest + deadline - now_seconds()) * 1000 + 0.999);
+
+        if(poll(fds, count + n, timeout) < 0 && errno != EINTR)
+            break;
+
+        // clients are only removed after the iteration, so the indices stay valid
+        for(size_t i = 0; i < n; i++)
+        {
+            Client *c = &get_vector_as_type(&clients, i, Client);
+            short ev = fds[count + i].revents;
+
+            if(ev & POLLOUT)
+                flush_client(c);
+            if(ev & (POLLIN | POLLHUP | POLLERR))
+                read_client(c);
+            if(ev & POLLNVAL)
+                c->broken = true;
+        }
+
+        for(size_t i = 0; i < count; i++)
+        {
+            if(fds[i].revents & POLLIN)
+                accept_clients(listeners[i], tcp[i]);
+        }
+
+        if(batches_complete())
+            flush_batches();
+
+        double now = now_seconds();
+        for(size_t i = 0; i < batches.size; i++)
+        {
+            Batch *b = get_vector_as_type(&batches, i, Batch*);
+            if(b->size > 0 && now - b->start >= deadline)
+                flush_batch(b);
+        }
+
+        remove_broken_clients();
+    }
+}
+
+
+int run_server(int argc, char *argv[])
+{
+    ServerOptions opt;
+    if(!parse_server_options(argc, argv, &opt))
+    {
+        fprintf(stderr, "Usage: --serve model.mlpmodel [--serve model.mlpmodel]... [--socket path] [--port n] [--batch n] [--deadline ms] [--threads n]\n");
+        free_vector(&opt.models);
+        return 1;
+    }
+
+    for(size_t i = 0; i < opt.models.size; i++)
+    {
+        if(!register_model(get_vector_as_type(&opt.models, i, const char*)))
+        {
+            free_registry();
+            free_vector(&opt.models);
+            return 1;
+        }
+    }
+    free_vector(&opt.models);
+
+    int listeners[2];
+    bool tcp[2] = {false, true};
+    size_t count = 0;
+
+    listeners[count] = listen_unix(opt.socket);
+    if(listeners[count++] < 0)
+    {
+        fprintf(stderr, "Couldn't listen on '%s'\n", opt.socket);
+        free_registry();
+        return 1;
+    }
+
+    if(opt.port > 0)
+    {
+        listeners[count] = listen_tcp(opt.port);
+        if(listeners[count++] < 0)
+        {
+            fprintf(stderr, "Couldn't listen on port %d\n", opt.port);
+            close(listeners[0]);
+            unlink(opt.socket);
+            free_registry();
+            return 1;
+        }
+    }
+
+    struct sigaction sa = {0};
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = on_reload;
+    sigaction(SIGHUP, &sa, NULL);
+
+    start_thread_pool(opt.threads);
+    thread_count = thread_pool_size();
+    batch_capacity = opt.batch;
+    clients = create_vector(16, sizeof(Client), false);
+    batches = create_vector(4, sizeof(Batch*), false);
+
+    fprintf(stderr, "Serving");
+    for(size_t i = 0; i < registered_model_count(); i++)
+        fprintf(stderr, "%s '%s'", i > 0 ? "," : "", get_registered_model(i)->mlp.name);
+    fprintf(stderr, " on %s", opt.socket);
+    if(opt.port > 0)
+        fprintf(stderr, " and 127.0.0.1:%d", opt.port);
+    fprintf(stderr, ", batches of up to %zu in %.1lf ms on %zu threads\n", batch_capacity, opt.deadline*1000, thread_count);
+
+    serve(listeners, tcp, count, opt.deadline);
+
+    flush_batches();
+    fprintf(stderr, "Served %zu requests in %zu batches, %.1lf requests per batch\n",
+        served, batch_runs, batch_runs > 0 ? (double) served/batch_runs : 0);
+
+    for(size_t i = 0; i < clients.size; i++)
+        get_vector_as_type(&clients, i, Client).broken = true;
+    remove_broken_clients();
+    free_vector(&clients);
+
+    for(size_t i = 0; i < count; i++)
+        close(listeners[i]);
+    unlink(opt.socket);
+
+    stop_thread_pool();
+    for(size_t i = 0; i < batches.size; i++)
+        free_batch(get_vector_as_type(&batches, i, Batch*));
+    free_vector(&batches);
+    free_registry();
+
+    return 0;
+}
+
+#endif
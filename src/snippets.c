@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
+#include <stdint.h>
 
 
 char* strclone(const char *str)
@@ -15,6 +17,22 @@ char* strclone(const char *str)
 }
 
 
+bool parse_size(const char *str, size_t *out)
+{
+    if(str[0] < '0' || str[0] > '9')
+        return false;
+
+    char *end;
+    errno = 0;
+    unsigned long long n = strtoull(str, &end, 10);
+    if(*end != '\0' || errno == ERANGE || n == 0 || n > SIZE_MAX)
+        return false;
+
+    *out = (size_t) n;
+    return true;
+}
+
+
 void memdump(char *filename, int line) {
     static int call = 0;
     DebugmallocData *instance = debugmalloc_singleton();
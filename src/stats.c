@@ -0,0 +1,67 @@
+#include "debugmalloc.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+
+double now_seconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec/1e9;
+}
+
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+
+    return (x > y) - (x < y);
+}
+
+
+double percentile(const double *sorted, size_t n, double p)
+{
+    size_t rank = ceil(p/100.0 * n);
+    if(rank == 0)
+        rank = 1;
+    if(rank > n)
+        rank = n;
+
+    return sorted[rank-1];
+}
+
+
+Summary summarize(Vector *samples)
+{
+    Summary s = {0};
+    size_t n = samples->size;
+    if(n == 0)
+        return s;
+
+    double *v = (double*) samples->arr;
+    qsort(v, n, sizeof(double), compare_doubles);
+
+    double sum = 0;
+    for(size_t i = 0; i < n; i++)
+        sum += v[i];
+
+    s.count = n;
+    s.mean = sum/n;
+
+    double sq = 0;
+    for(size_t i = 0; i < n; i++)
+        sq += (v[i] - s.mean)*(v[i] - s.mean);
+    s.stddev = n > 1 ? sqrt(sq/(n-1)) : 0;
+
+    s.min = v[0];
+    s.max = v[n-1];
+    s.median = n % 2 ? v[n/2] : (v[n/2-1] + v[n/2])/2;
+    s.p95 = percentile(v, n, 95);
+    s.p99 = percentile(v, n, 99);
+
+    return s;
+}
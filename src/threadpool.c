@@ -0,0 +1,179 @@
+#include "debugmalloc.h"
+#include "threadpool.h"
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "errors.h"
+
+
+static pthread_t *threads = NULL;
+static size_t thread_count = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+
+static ParallelTask task = NULL;
+static void *task_arg = NULL;
+static size_t task_count = 0;
+/** The next index that isn't claimed by any thread yet. */
+static atomic_size_t next_index = 0;
+/** Number of workers that haven't finished the current run. */
+static size_t busy = 0;
+/** Incremented by every run, so the workers can tell a new run from a spurious wakeup. */
+static size_t generation = 0;
+/** The generation when the workers were started, as a run can begin before a worker gets to wait for it. */
+static size_t first_generation = 0;
+static bool stopping = false;
+
+
+size_t processor_count()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long n = info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return n > 0 ? (size_t) n : 1;
+}
+
+
+/**
+ * Claims and runs the indices of the current run until none is left.
+ */
+static void run_tasks()
+{
+    size_t i;
+    while((i = atomic_fetch_add(&next_index, 1)) < task_count)
+        task(task_arg, i);
+}
+
+
+/**
+ * The main loop of a worker thread.
+ * Helps with every run until the pool is stopped.
+ */
+static void* worker_loop(void *arg)
+{
+    pthread_mutex_lock(&lock);
+    size_t seen = first_generation;
+    while(true)
+    {
+        while(generation == seen && !stopping)
+            pthread_cond_wait(&wake, &lock);
+
+        if(stopping)
+            break;
+
+        seen = generation;
+        pthread_mutex_unlock(&lock);
+
+        run_tasks();
+
+        pthread_mutex_lock(&lock);
+        if(--busy == 0)
+            pthread_cond_signal(&done);
+    }
+    pthread_mutex_unlock(&lock);
+
+    return NULL;
+}
+
+
+bool start_thread_pool(size_t count)
+{
+    if(threads != NULL)
+        return true;
+
+    size_t cpus = processor_count();
+    if(count == 0)
+        count = cpus;
+    else if(count > MAX_THREADS_PER_PROCESSOR * cpus)
+        count = MAX_THREADS_PER_PROCESSOR * cpus;
+
+    size_t n = count - 1;
+    if(n == 0)
+        return true;
+
+    threads = (pthread_t*) malloc(n * sizeof(pthread_t));
+    if(threads == NULL)
+        exit(ERR_NULLPOINTER);
+
+    stopping = false;
+    first_generation = generation;
+    for(thread_count = 0; thread_count < n; thread_count++)
+    {
+        if(pthread_create(&threads[thread_count], NULL, worker_loop, NULL) != 0)
+            break;
+    }
+
+    if(thread_count == 0)
+    {
+        free(threads);
+        threads = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+
+size_t thread_pool_size()
+{
+    return thread_count + 1;
+}
+
+
+void run_parallel(ParallelTask t, void *arg, size_t count)
+{
+    if(thread_count == 0 || count <= 1)
+    {
+        for(size_t i = 0; i < count; i++)
+            t(arg, i);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    task = t;
+    task_arg = arg;
+    task_count = count;
+    atomic_store(&next_index, 0);
+    busy = thread_count;
+    generation++;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&lock);
+
+    run_tasks();
+
+    pthread_mutex_lock(&lock);
+    while(busy > 0)
+        pthread_cond_wait(&done, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+
+void stop_thread_pool()
+{
+    if(threads == NULL)
+        return;
+
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&lock);
+
+    for(size_t i = 0; i < thread_count; i++)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+    threads = NULL;
+    thread_count = 0;
+}